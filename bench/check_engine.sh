@@ -0,0 +1,105 @@
+#!/bin/sh
+# Copyright (c) Centre de Calcul de l'IN2P3 du CNRS
+# Contributor(s) : Frédéric SUTER (2012-2016)
+# This program is free software; you can redistribute it and/or modify it
+# under the terms of the license (GNU LGPL) which comes with this package.
+#
+# Validation of the native simulation engine against SimGrid. DPDS and WA-DPDS are run with both engines on each DAX
+# of daxfiles/ alone, and on the ensemble of all of them, without network contention (--network none) as the native
+# engine does not model it. The schedules (--dump) have to be made of the same events, at the same times up to
+# TOLERANCE seconds, and the results (makespan, completed DAXes, cost and score) have to be the same. One line is
+# written on the standard output per run, with the scheduling times of both engines and the speedup of the native one,
+# followed by the overall speedup. The exit status is 1 if any run differs or fails.
+#
+# Usage: bench/check_engine.sh
+# Environment: WORKDIR (logs and dumps, default bench/work), PLATFORM (default cluster.xml), BUDGET (default 100),
+#              DEADLINE (default 36000), TOLERANCE (default 0.001)
+
+BENCH_DIR=$(dirname "$0")
+EXE=${EXE:-$BENCH_DIR/../EnsembleSched}
+WORKDIR=${WORKDIR:-$BENCH_DIR/work}
+PLATFORM=${PLATFORM:-$BENCH_DIR/../cluster.xml}
+BUDGET=${BUDGET:-100}
+DEADLINE=${DEADLINE:-36000}
+TOLERANCE=${TOLERANCE:-0.001}
+ALGS="DPDS WA-DPDS"
+
+mkdir -p "$WORKDIR"
+
+# Extract the first number that follows a given pattern in a log
+extract() {
+  sed -n "s/.*$1\([0-9.e+-]*\).*/\1/p" "$2" | head -n 1
+}
+
+# Number of differences between two dumps. Events are matched by their other fields, in their order of occurrence,
+# as the dumps are not sorted. Their times may differ by TOLERANCE seconds at most.
+compare_dumps() {
+  awk -F, -v tolerance="$TOLERANCE" '
+    FNR == 1 { next }
+    { key = $2 "," $3 "," $4 "," $5; key = key "#" (++occurrences[FILENAME, key]) }
+    FILENAME == ARGV[1] { time[key] = $1; rest[key] = $6 "," $7; next }
+    !(key in time) { differences++; next }
+    {
+      delta = $1 - time[key];
+      if (delta > tolerance || -delta > tolerance || rest[key] != $6 "," $7)
+        differences++;
+      delete time[key];
+    }
+    END { for (key in time) differences++; print differences + 0 }' "$1" "$2"
+}
+
+# Results of a run, as a single line
+results() {
+  echo "$(extract 'Makespan: ' "$1") $(extract 'Success rate: ' "$1") $(extract 'Total cost: \$' "$1")" \
+       "$(extract 'Score: ' "$1")"
+}
+
+# Run an ensemble with both engines: name, algorithm, DAX arguments
+run_ensemble() {
+  name=$1; alg=$2; shift 2
+  for engine in simgrid native; do
+    "$EXE" --alg "$alg" --platform "$PLATFORM" "$@" --budget "$BUDGET" --deadline "$DEADLINE" --network none \
+      --engine $engine --dump "$WORKDIR/engine_${name}_${alg}_$engine.csv" \
+      > "$WORKDIR/engine_${name}_${alg}_$engine.log" 2>&1 || \
+      { echo "$name $alg: FAILED (--engine $engine, see $WORKDIR/engine_${name}_${alg}_$engine.log)"; return 1; }
+  done
+
+  simgrid_log=$WORKDIR/engine_${name}_${alg}_simgrid.log
+  native_log=$WORKDIR/engine_${name}_${alg}_native.log
+  simgrid_time=$(extract 'Scheduling time: ' "$simgrid_log"); simgrid_time=${simgrid_time:-0}
+  native_time=$(extract 'Scheduling time: ' "$native_log"); native_time=${native_time:-0}
+  total_simgrid=$(awk "BEGIN {print $total_simgrid + $simgrid_time}")
+  total_native=$(awk "BEGIN {print $total_native + $native_time}")
+  speedup=$(awk "BEGIN {printf \"%.1f\", ($native_time > 0 ? $simgrid_time / $native_time : 0)}")
+  differences=$(compare_dumps "$WORKDIR/engine_${name}_${alg}_simgrid.csv" \
+                              "$WORKDIR/engine_${name}_${alg}_native.csv")
+
+  if [ "$(results "$simgrid_log")" != "$(results "$native_log")" ] || [ "$differences" -ne 0 ]; then
+    echo "$name $alg: DIFFERENT ($differences events, results '$(results "$simgrid_log")' with SimGrid and" \
+         "'$(results "$native_log")' with the native engine), ${simgrid_time}s vs ${native_time}s, speedup $speedup"
+    return 1
+  fi
+  echo "$name $alg: same schedule, ${simgrid_time}s vs ${native_time}s, speedup $speedup"
+}
+
+failures=0
+total_simgrid=0
+total_native=0
+all=""
+for dax in "$BENCH_DIR"/../daxfiles/*.xml; do
+  all="$all --dax $dax"
+  for alg in $ALGS; do
+    run_ensemble "$(basename "$dax" .xml)" "$alg" --dax "$dax" || failures=$((failures + 1))
+  done
+done
+for alg in $ALGS; do
+  run_ensemble all "$alg" $all || failures=$((failures + 1))
+done
+
+echo "Overall speedup of the native engine: $(awk "BEGIN {printf \"%.1f\", \
+  ($total_native > 0 ? $total_simgrid / $total_native : 0)}") (${total_simgrid}s vs ${total_native}s)"
+if [ $failures -ne 0 ]; then
+  echo "$failures run(s) differ or failed"
+  exit 1
+fi
+echo "Both engines give the same schedules"
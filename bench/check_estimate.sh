@@ -0,0 +1,93 @@
+#!/bin/sh
+# Copyright (c) Centre de Calcul de l'IN2P3 du CNRS
+# Contributor(s) : Frédéric SUTER (2012-2016)
+# This program is free software; you can redistribute it and/or modify it
+# under the terms of the license (GNU LGPL) which comes with this package.
+#
+# Check of the bounds computed by --estimate against actual simulations. The ensemble of the shipped DAXes (daxfiles/)
+# is scheduled by each algorithm over a grid of budgets and deadlines. For each point, the bounds are computed without
+# simulating, then the simulation is run and its makespan, number of completed DAXes, cost and score have to be within
+# these bounds (up to the precision of the output). One line is written on the standard output per point, and the exit
+# status is 1 if any bound is violated or any run fails.
+#
+# Usage: bench/check_estimate.sh
+# Environment: WORKDIR (logs, default bench/work), PLATFORM (default cluster.xml)
+
+BENCH_DIR=$(dirname "$0")
+EXE=${EXE:-$BENCH_DIR/../EnsembleSched}
+WORKDIR=${WORKDIR:-$BENCH_DIR/work}
+PLATFORM=${PLATFORM:-$BENCH_DIR/../cluster.xml}
+ALGS="DPDS WA-DPDS SPSS"
+BUDGETS="20 50 100 200 400"
+DEADLINES="3600 10000 36000"
+
+mkdir -p "$WORKDIR"
+
+DAXES=""
+for dax in "$BENCH_DIR"/../daxfiles/*.xml; do
+  DAXES="$DAXES --dax $dax"
+done
+
+# Extract the first number that follows a given pattern in a log
+extract() {
+  sed -n "s/.*$1\([0-9.e+-]*\).*/\1/p" "$2" | head -n 1
+}
+
+failures=0
+for alg in $ALGS; do
+  for budget in $BUDGETS; do
+    for deadline in $DEADLINES; do
+      point="$alg budget=$budget deadline=$deadline"
+      bounds=$WORKDIR/estimate_${alg}_${budget}_${deadline}.log
+      log=$WORKDIR/simulate_${alg}_${budget}_${deadline}.log
+      args="--alg $alg --platform $PLATFORM $DAXES --budget $budget --deadline $deadline"
+
+      if ! "$EXE" $args --estimate > "$bounds" 2>&1; then
+        echo "$point: FAILED (--estimate, see $bounds)"
+        failures=$((failures + 1))
+        continue
+      fi
+      # A regular run also checks its own results against the bounds, and exits with status 1 if they are violated
+      "$EXE" $args > "$log" 2>&1
+      status=$?
+
+      min_makespan=$(extract 'Makespan: at least ' "$bounds")
+      max_completed=$(extract 'Success rate: at most ' "$bounds")
+      min_cost=$(extract 'Total cost: at least \$' "$bounds")
+      max_score=$(extract 'Score: at most ' "$bounds")
+      makespan=$(extract 'Makespan: ' "$log")
+      completed=$(extract 'Success rate: ' "$log")
+      cost=$(extract 'Total cost: \$' "$log")
+      score=$(extract 'Score: ' "$log")
+
+      if [ -z "$min_makespan" ] || [ -z "$max_completed" ] || [ -z "$min_cost" ] || [ -z "$max_score" ] || \
+         [ -z "$makespan" ] || [ -z "$completed" ] || [ -z "$cost" ] || [ -z "$score" ]; then
+        echo "$point: FAILED (status $status, see $log)"
+        failures=$((failures + 1))
+        continue
+      fi
+
+      # Makespans are displayed with 3 decimals, costs with 2 and scores with 6
+      violations=$(awk -v m="$makespan" -v mm="$min_makespan" -v c="$completed" -v mc="$max_completed" \
+                       -v k="$cost" -v mk="$min_cost" -v s="$score" -v ms="$max_score" 'BEGIN {
+        if (m < mm - 0.001) printf " makespan %s < %s", m, mm;
+        if (c > mc) printf " completed %s > %s", c, mc;
+        if (k < mk - 0.01) printf " cost %s < %s", k, mk;
+        if (s > ms + 0.000001) printf " score %s > %s", s, ms;
+      }')
+      if [ -n "$violations" ] || [ $status -ne 0 ]; then
+        echo "$point: VIOLATION (status $status)$violations"
+        failures=$((failures + 1))
+      else
+        echo "$point: ok (makespan $makespan >= $min_makespan, completed $completed <= $max_completed," \
+             "cost $cost >= $min_cost, score $score <= $max_score)"
+      fi
+    done
+  done
+done
+
+if [ $failures -ne 0 ]; then
+  echo "$failures point(s) out of bounds or failed"
+  exit 1
+fi
+echo "All the results are within their bounds"
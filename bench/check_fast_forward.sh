@@ -0,0 +1,84 @@
+#!/bin/sh
+# Copyright (c) Centre de Calcul de l'IN2P3 du CNRS
+# Contributor(s) : Frédéric SUTER (2012-2016)
+# This program is free software; you can redistribute it and/or modify it
+# under the terms of the license (GNU LGPL) which comes with this package.
+#
+# Check that --fast-forward does not change the schedule. The ensemble of the shipped DAXes (daxfiles/) is scheduled by
+# DPDS and WA-DPDS, the algorithms that wake up at each provisioning period, over the grid of budgets and deadlines of
+# check_estimate.sh. For each point, the run with --fast-forward has to give the same makespan, number of completed
+# DAXes, cost and score as the run that wakes up at every period, and the same events in its schedule (--dump), apart
+# from the utilization samples of the skipped periods. One line is written on the standard output per point, and the
+# exit status is 1 if any point differs or any run fails.
+#
+# Usage: bench/check_fast_forward.sh
+# Environment: WORKDIR (logs and dumps, default bench/work), PLATFORM (default cluster.xml)
+
+BENCH_DIR=$(dirname "$0")
+EXE=${EXE:-$BENCH_DIR/../EnsembleSched}
+WORKDIR=${WORKDIR:-$BENCH_DIR/work}
+PLATFORM=${PLATFORM:-$BENCH_DIR/../cluster.xml}
+ALGS="DPDS WA-DPDS"
+BUDGETS="20 50 100 200 400"
+DEADLINES="3600 10000 36000"
+
+mkdir -p "$WORKDIR"
+
+DAXES=""
+for dax in "$BENCH_DIR"/../daxfiles/*.xml; do
+  DAXES="$DAXES --dax $dax"
+done
+
+# Extract the first number that follows a given pattern in a log
+extract() {
+  sed -n "s/.*$1\([0-9.e+-]*\).*/\1/p" "$2" | head -n 1
+}
+
+# Results of a run, as a single line
+results() {
+  echo "$(extract 'Makespan: ' "$1") $(extract 'Success rate: ' "$1") $(extract 'Total cost: \$' "$1")" \
+       "$(extract 'Score: ' "$1")"
+}
+
+failures=0
+for alg in $ALGS; do
+  for budget in $BUDGETS; do
+    for deadline in $DEADLINES; do
+      point="$alg budget=$budget deadline=$deadline"
+      name=${alg}_${budget}_${deadline}
+      args="--alg $alg --platform $PLATFORM $DAXES --budget $budget --deadline $deadline"
+
+      # The regular run may exit with status 1 if its results are out of the estimated bounds, which
+      # check_estimate.sh reports. Only missing results make a run fail here.
+      "$EXE" $args --dump "$WORKDIR/periods_$name.csv" > "$WORKDIR/periods_$name.log" 2>&1
+      "$EXE" $args --fast-forward --dump "$WORKDIR/fast_forward_$name.csv" > "$WORKDIR/fast_forward_$name.log" 2>&1
+
+      periods=$(results "$WORKDIR/periods_$name.log")
+      fast_forward=$(results "$WORKDIR/fast_forward_$name.log")
+      if [ "$(echo $periods | wc -w)" -ne 4 ] || [ "$(echo $fast_forward | wc -w)" -ne 4 ]; then
+        echo "$point: FAILED (see $WORKDIR/periods_$name.log and $WORKDIR/fast_forward_$name.log)"
+        failures=$((failures + 1))
+        continue
+      fi
+
+      # The utilization samples (period events) of the skipped periods are not written with --fast-forward
+      differences=$(grep -v '^[^,]*,period,' "$WORKDIR/periods_$name.csv" > "$WORKDIR/periods_$name.events"
+                    grep -v '^[^,]*,period,' "$WORKDIR/fast_forward_$name.csv" > "$WORKDIR/fast_forward_$name.events"
+                    diff "$WORKDIR/periods_$name.events" "$WORKDIR/fast_forward_$name.events" | grep -c '^[<>]')
+
+      if [ "$periods" != "$fast_forward" ] || [ "$differences" -ne 0 ]; then
+        echo "$point: DIFFERENT ($differences events, results '$periods' at every period and '$fast_forward'" \
+             "with --fast-forward)"
+        failures=$((failures + 1))
+      else
+        echo "$point: same schedule (makespan, completed, cost, score: $periods)"
+      fi
+    done
+  done
+done
+
+if [ $failures -ne 0 ]; then
+  echo "$failures point(s) differ or failed"
+  exit 1
+fi
+echo "--fast-forward gives the same schedules"
@@ -0,0 +1,285 @@
+/*
+ * Copyright (c) Centre de Calcul de l'IN2P3 du CNRS
+ * Contributor(s) : Frédéric SUTER (2012-2016)
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the license (GNU LGPL) which comes with this package.
+ *
+ * generate.c
+ * Generator of synthetic inputs for the benchmark suite (see bench/run.sh):
+ *   generate dax <shape> <number of tasks> <seed> <output file>
+ *   generate platform <number of hosts> <output file>
+ * Shapes mimic the structure of the workflows studied in "Characterizing and Profiling Scientific Workflows" by Juve
+ * et al.: Montage, CyberShake, Epigenomics, Inspiral, and Sipht. The number of tasks is an approximation, as each
+ * shape needs a given number of tasks per level. Runtimes and file sizes are random, but deterministic for a given
+ * seed.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct _Job {
+  const char *name;
+  double runtime;
+  int nparents;
+  int *parents;
+  int capacity;
+} Job;
+
+static Job *jobs = NULL;
+static int njobs = 0;
+static int max_jobs = 0;
+static unsigned long long rng_state;
+
+/* 48-bit linear congruential generator, to get the same DAX on every platform for a given seed */
+static double uniform(){
+  rng_state = (rng_state * 0x5DEECE66DULL + 0xB) & ((1ULL << 48) - 1);
+  return (double) (rng_state >> 16) / (double) (1ULL << 32);
+}
+
+/* Add a job whose runtime is drawn between mean/2 and 3*mean/2 and return its index */
+static int add_job(const char *name, double mean_runtime){
+  if (njobs == max_jobs){
+    max_jobs = max_jobs ? 2 * max_jobs : 1024;
+    jobs = (Job *) realloc (jobs, max_jobs * sizeof(Job));
+  }
+  jobs[njobs].name = name;
+  jobs[njobs].runtime = mean_runtime * (0.5 + uniform());
+  jobs[njobs].nparents = 0;
+  jobs[njobs].parents = NULL;
+  jobs[njobs].capacity = 0;
+  return njobs++;
+}
+
+static void add_dependency(int parent, int child){
+  Job *job = &(jobs[child]);
+
+  if (job->nparents == job->capacity){
+    job->capacity = job->capacity ? 2 * job->capacity : 4;
+    job->parents = (int *) realloc (job->parents, job->capacity * sizeof(int));
+  }
+  job->parents[job->nparents++] = parent;
+}
+
+/* Add a job that depends on parent and return its index */
+static int add_chain(int parent, const char *name, double mean_runtime){
+  int job = add_job(name, mean_runtime);
+
+  add_dependency(parent, job);
+  return job;
+}
+
+/* mProjectPP (k) -> mDiffFit (pairs of overlapping images) -> mConcatFit -> mBgModel -> mBackground (k, each also
+ * depends on its projection) -> mImgtbl -> mAdd -> mShrink -> mJPEG
+ */
+static void generate_montage(int n){
+  int i, k = (n - 6) / 3 > 1 ? (n - 6) / 3 : 1;
+  int ndiffs = n - 2 * k - 6 > 1 ? n - 2 * k - 6 : 1;
+  int first_project, first_diff, concat, model, imgtbl, job;
+
+  first_project = njobs;
+  for (i = 0; i < k; i++)
+    add_job("mProjectPP", 13.6);
+  first_diff = njobs;
+  for (i = 0; i < ndiffs; i++){
+    job = add_job("mDiffFit", 10.6);
+    add_dependency(first_project + i % k, job);
+    if ((i + 1 + i / k) % k != i % k)
+      add_dependency(first_project + (i + 1 + i / k) % k, job);
+  }
+  concat = add_job("mConcatFit", 143.3);
+  for (i = 0; i < ndiffs; i++)
+    add_dependency(first_diff + i, concat);
+  model = add_job("mBgModel", 384.5);
+  add_dependency(concat, model);
+  imgtbl = add_job("mImgtbl", 2.6);
+  for (i = 0; i < k; i++){
+    job = add_job("mBackground", 10.9);
+    add_dependency(model, job);
+    add_dependency(first_project + i, job);
+    add_dependency(job, imgtbl);
+  }
+  job = add_job("mAdd", 282.4);
+  add_dependency(imgtbl, job);
+  add_chain(job, "mShrink", 66.1);
+  add_chain(njobs - 1, "mJPEG", 0.7);
+}
+
+/* ExtractSGT (one per rupture) -> SeismogramSynthesis -> PeakValCalcOkaya. Seismograms and peak values are zipped */
+static void generate_cybershake(int n){
+  int i, nextract = n / 25 > 1 ? n / 25 : 1;
+  int nsynthesis = (n - nextract - 2) / 2 > 1 ? (n - nextract - 2) / 2 : 1;
+  int first_extract, zip_seis, zip_psa, synthesis, peak;
+
+  first_extract = njobs;
+  for (i = 0; i < nextract; i++)
+    add_job("ExtractSGT", 110.6);
+  zip_seis = add_job("ZipSeis", 58.6);
+  zip_psa = add_job("ZipPSA", 0.1);
+  for (i = 0; i < nsynthesis; i++){
+    synthesis = add_job("SeismogramSynthesis", 79.5);
+    add_dependency(first_extract + i % nextract, synthesis);
+    add_dependency(synthesis, zip_seis);
+    peak = add_job("PeakValCalcOkaya", 1.0);
+    add_dependency(synthesis, peak);
+    add_dependency(peak, zip_psa);
+  }
+}
+
+/* fastQSplit (one per lane) -> chains of filterContams -> sol2sanger -> fast2bfq -> map -> mapMerge (per lane) ->
+ * mapMerge -> maqIndex -> pileup
+ */
+static void generate_epigenomics(int n){
+  int i, j, lanes = 1 + n / 200;
+  int chunks = (n - 3 - 2 * lanes) / (4 * lanes) > 1 ? (n - 3 - 2 * lanes) / (4 * lanes) : 1;
+  int split, merge, global_merge, job;
+
+  global_merge = add_job("mapMerge", 16.2);
+  for (i = 0; i < lanes; i++){
+    split = add_job("fastQSplit", 34.3);
+    merge = add_job("mapMerge", 16.2);
+    for (j = 0; j < chunks; j++){
+      job = add_chain(split, "filterContams", 2.5);
+      job = add_chain(job, "sol2sanger", 0.5);
+      job = add_chain(job, "fast2bfq", 1.4);
+      job = add_chain(job, "map", 201.9);
+      add_dependency(job, merge);
+    }
+    add_dependency(merge, global_merge);
+  }
+  job = add_chain(global_merge, "maqIndex", 43.8);
+  add_chain(job, "pileup", 55.9);
+}
+
+/* Independent groups of TmpltBank -> Inspiral -> Thinca -> TrigBank -> Inspiral -> Thinca */
+static void generate_inspiral(int n){
+  int i, g, groups = 1 + n / 60;
+  int width = (n / groups - 2) / 4 > 1 ? (n / groups - 2) / 4 : 1;
+  int thinca, thinca2, job;
+
+  for (g = 0; g < groups; g++){
+    thinca = add_job("Thinca", 5.4);
+    for (i = 0; i < width; i++){
+      job = add_job("TmpltBank", 18.1);
+      add_dependency(add_chain(job, "Inspiral", 460.2), thinca);
+    }
+    thinca2 = add_job("Thinca", 5.4);
+    for (i = 0; i < width; i++){
+      job = add_chain(thinca, "TrigBank", 5.1);
+      add_dependency(add_chain(job, "Inspiral", 460.2), thinca2);
+    }
+  }
+}
+
+/* Patser (many) -> Patser_concate, and Transterm, Findterm, RNAMotif, Blast -> SRNA -> five BLAST-based analyses ->
+ * SRNA_annotate
+ */
+static void generate_sipht(int n){
+  static const char *roots[] = {"Transterm", "Findterm", "RNAMotif", "Blast"};
+  static const double root_runtimes[] = {32.4, 594.9, 25.6, 3311.1};
+  static const char *analyses[] = {"FFN_parse", "BLAST_synteny", "BLAST_candidate", "BLAST_QRNA", "BLAST_paralogues"};
+  static const double analysis_runtimes[] = {0.7, 3.4, 0.6, 440.8, 0.7};
+  int i, npatser = n - 12 > 1 ? n - 12 : 1;
+  int concat, srna, annotate, job;
+
+  concat = add_job("Patser_concate", 0.1);
+  for (i = 0; i < npatser; i++){
+    job = add_job("Patser", 0.9);
+    add_dependency(job, concat);
+  }
+  srna = add_chain(concat, "SRNA", 12.4);
+  for (i = 0; i < 4; i++){
+    job = add_job(roots[i], root_runtimes[i]);
+    add_dependency(job, srna);
+  }
+  annotate = add_job("SRNA_annotate", 0.1);
+  for (i = 0; i < 5; i++){
+    job = add_chain(srna, analyses[i], analysis_runtimes[i]);
+    add_dependency(job, annotate);
+  }
+}
+
+/* Write the jobs in the DAX format read by SD_daxload. Each job produces one file, read by all its children. */
+static void write_dax(FILE *f, const char *shape){
+  int i, j;
+
+  fprintf(f, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
+  fprintf(f, "<adag xmlns=\"http://pegasus.isi.edu/schema/DAX\" version=\"2.1\" count=\"1\" index=\"0\" "
+          "name=\"%s\" jobCount=\"%d\">\n", shape, njobs);
+  for (i = 0; i < njobs; i++){
+    fprintf(f, "  <job id=\"ID%07d\" namespace=\"%s\" name=\"%s\" version=\"1.0\" runtime=\"%.2f\">\n", i, shape,
+            jobs[i].name, jobs[i].runtime);
+    for (j = 0; j < jobs[i].nparents; j++)
+      fprintf(f, "    <uses file=\"f%07d\" link=\"input\" size=\"%.0f\"/>\n", jobs[i].parents[j],
+              1e3 + 1e7 * uniform() * uniform());
+    fprintf(f, "    <uses file=\"f%07d\" link=\"output\" size=\"%.0f\"/>\n", i, 1e3 + 1e7 * uniform() * uniform());
+    fprintf(f, "  </job>\n");
+  }
+  for (i = 0; i < njobs; i++){
+    if (!jobs[i].nparents)
+      continue;
+    fprintf(f, "  <child ref=\"ID%07d\">\n", i);
+    for (j = 0; j < jobs[i].nparents; j++)
+      fprintf(f, "    <parent ref=\"ID%07d\"/>\n", jobs[i].parents[j]);
+    fprintf(f, "  </child>\n");
+  }
+  fprintf(f, "</adag>\n");
+}
+
+/* Same cluster as cluster.xml, with a given number of hosts */
+static void write_platform(FILE *f, int nhosts){
+  fprintf(f, "<?xml version='1.0'?>\n");
+  fprintf(f, "<!DOCTYPE platform SYSTEM \"http://simgrid.gforge.inria.fr/simgrid.dtd\">\n");
+  fprintf(f, "<platform version=\"3\">\n");
+  fprintf(f, "<AS  id=\"AS0\"  routing=\"Full\">\n");
+  fprintf(f, "  <cluster id=\"my_cloud\" prefix=\"c-\" suffix=\".me\"\n");
+  fprintf(f, "  \t   radical=\"0-%d\"\tpower=\"4200000000\"    bw=\"125000000\"     lat=\"5E-5\"\n", nhosts - 1);
+  fprintf(f, "        bb_bw=\"2250000000\" bb_lat=\"5E-4\"/>\n");
+  fprintf(f, "</AS>\n");
+  fprintf(f, "</platform>\n");
+}
+
+static void usage(const char *program){
+  fprintf(stderr, "Usage: %s dax <Montage|CyberShake|Epigenomics|Inspiral|Sipht> <ntasks> <seed> <file>\n", program);
+  fprintf(stderr, "       %s platform <nhosts> <file>\n", program);
+  exit(1);
+}
+
+int main(int argc, char **argv){
+  int i;
+  FILE *f;
+
+  if (argc == 6 && !strcmp(argv[1], "dax")){
+    rng_state = strtoull(argv[4], NULL, 10);
+    if (!strcmp(argv[2], "Montage"))
+      generate_montage(atoi(argv[3]));
+    else if (!strcmp(argv[2], "CyberShake"))
+      generate_cybershake(atoi(argv[3]));
+    else if (!strcmp(argv[2], "Epigenomics"))
+      generate_epigenomics(atoi(argv[3]));
+    else if (!strcmp(argv[2], "Inspiral"))
+      generate_inspiral(atoi(argv[3]));
+    else if (!strcmp(argv[2], "Sipht"))
+      generate_sipht(atoi(argv[3]));
+    else
+      usage(argv[0]);
+    if (!(f = fopen(argv[5], "w"))){
+      perror(argv[5]);
+      return 1;
+    }
+    write_dax(f, argv[2]);
+    fclose(f);
+    for (i = 0; i < njobs; i++)
+      free(jobs[i].parents);
+    free(jobs);
+  } else if (argc == 4 && !strcmp(argv[1], "platform")){
+    if (!(f = fopen(argv[3], "w"))){
+      perror(argv[3]);
+      return 1;
+    }
+    write_platform(f, atoi(argv[2]));
+    fclose(f);
+  } else {
+    usage(argv[0]);
+  }
+  return 0;
+}
@@ -0,0 +1,92 @@
+#!/bin/sh
+# Copyright (c) Centre de Calcul de l'IN2P3 du CNRS
+# Contributor(s) : Frédéric SUTER (2012-2016)
+# This program is free software; you can redistribute it and/or modify it
+# under the terms of the license (GNU LGPL) which comes with this package.
+#
+# Scalability benchmark of EnsembleSched (DPDS). Three axes are varied one at a time around a base point (10 DAXes of
+# 50 tasks on 1000 VMs): the number of DAXes, the number of tasks per DAX, and the size of the VM pool. Ensembles mix
+# the five workflow shapes of bench/generate.c. One CSV line is written on the standard output per point.
+#
+# Usage: bench/run.sh [quick|full]
+# Environment: WORKDIR (generated inputs, default bench/work), TIMEOUT (per run in seconds, default 3600)
+
+MODE=${1:-quick}
+BENCH_DIR=$(dirname "$0")
+EXE=${EXE:-$BENCH_DIR/../EnsembleSched}
+GENERATE=${GENERATE:-$BENCH_DIR/generate}
+WORKDIR=${WORKDIR:-$BENCH_DIR/work}
+TIMEOUT=${TIMEOUT:-3600}
+SHAPES="Montage CyberShake Epigenomics Inspiral Sipht"
+
+BASE_DAXES=10
+BASE_TASKS=50
+BASE_VMS=1000
+case $MODE in
+  quick)
+    DAXES="10 100"
+    TASKS="50 500"
+    VMS="100 1000";;
+  full)
+    DAXES="10 100 1000 10000"
+    TASKS="50 500 5000 10000"
+    VMS="100 1000 10000 100000";;
+  *)
+    echo "Usage: $0 [quick|full]" >&2
+    exit 1;;
+esac
+
+mkdir -p "$WORKDIR"
+
+# Extract the first number that follows a given label in the output of a run
+extract() {
+  sed -n "s/.*$1 \([0-9.e+-]*\).*/\1/p" "$2" | head -n 1
+}
+
+# Run a point: number of DAXes, tasks per DAX, number of VMs
+run_point() {
+  axis=$1; ndaxes=$2; ntasks=$3; nvms=$4
+  platform=$WORKDIR/platform_$nvms.xml
+  log=$WORKDIR/run_${ndaxes}_${ntasks}_${nvms}.log
+  [ -f "$platform" ] || "$GENERATE" platform "$nvms" "$platform"
+
+  # Each shape is instantiated ndaxes/5 times (at least once) from a single file
+  repeat=$(( (ndaxes + 4) / 5 ))
+  args=""
+  for shape in $SHAPES; do
+    dax=$WORKDIR/${shape}_$ntasks.xml
+    [ -f "$dax" ] || "$GENERATE" dax "$shape" "$ntasks" 1 "$dax"
+    args="$args --dax-repeat $dax:$repeat"
+  done
+
+  # Deadline of 10 hours, and a budget that starts half of the VM pool at a price of $1/h
+  start=$(date +%s.%N)
+  timeout "$TIMEOUT" "$EXE" --alg DPDS --platform "$platform" $args --deadline 36000 --budget $(( 5 * nvms )) \
+    > "$log" 2>&1
+  status=$?
+  end=$(date +%s.%N)
+
+  printf "%s,%d,%d,%d,%s,%s,%s,%s,%s,%s,%s,%s,%s,%s,%d\n" "$axis" $(( 5 * repeat )) "$ntasks" "$nvms" \
+    "$(extract 'Load time:' "$log")" \
+    "$(sed -n 's/.*Load time: .*(\([0-9]*\) tasks).*/\1/p' "$log")" \
+    "$(awk "BEGIN {printf \"%.3f\", $end - $start}")" \
+    "$(extract 'Scheduling time:' "$log")" \
+    "$(sed -n 's/.*Scheduling time: .*(\([0-9]*\) events.*/\1/p' "$log")" \
+    "$(sed -n 's/.*events, \([0-9.]*\) us\/event.*/\1/p' "$log")" \
+    "$(extract 'Peak RSS:' "$log")" \
+    "$(extract 'Makespan:' "$log")" \
+    "$(sed -n 's/.*Success rate: \([0-9]*\)\/.*/\1/p' "$log")" \
+    "$(extract 'Score:' "$log")" \
+    $status
+}
+
+echo "axis,daxes,tasks_per_dax,vms,load_time,tasks,wall_time,scheduling_time,events,us_per_event,peak_rss_kib,makespan,completed,score,status"
+for n in $DAXES; do
+  run_point daxes "$n" $BASE_TASKS $BASE_VMS
+done
+for n in $TASKS; do
+  run_point tasks $BASE_DAXES "$n" $BASE_VMS
+done
+for n in $VMS; do
+  run_point vms $BASE_DAXES $BASE_TASKS "$n"
+done
@@ -0,0 +1,29 @@
+/*
+ * Copyright (c) Centre de Calcul de l'IN2P3 du CNRS
+ * Contributor(s) : Frédéric SUTER (2012-2016)
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the license (GNU LGPL) which comes with this package.
+ */
+
+#ifndef ARRIVAL_H_
+#define ARRIVAL_H_
+#include "simgrid/simdag.h"
+
+/* Online mode: workflows arrive over time instead of being all submitted at the beginning of the simulation */
+typedef struct _Arrival {
+  double time;
+  char *filename;
+  int drawn;        /* 1 if drawn from a Poisson process, 0 if read from a trace */
+} Arrival;
+
+void arrivals_read_trace(const char *);
+void arrivals_generate_poisson(double, double, xbt_dynar_t);
+void arrivals_redraw();
+void arrivals_set_cache_dir(const char *);
+int get_number_of_arrivals();
+int get_number_of_pending_arrivals();
+double get_next_arrival_time();
+xbt_dynar_t load_next_arrival();
+void free_arrivals();
+
+#endif /* ARRIVAL_H_ */
@@ -0,0 +1,33 @@
+/*
+ * Copyright (c) Centre de Calcul de l'IN2P3 du CNRS
+ * Contributor(s) : Frédéric SUTER (2012-2016)
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the license (GNU LGPL) which comes with this package.
+ */
+
+#ifndef BILLING_H_
+#define BILLING_H_
+#include "simgrid/simdag.h"
+
+/* Duration of a billing cycle in seconds. VMs are charged by the hour */
+#define BILLING_CYCLE 3600
+
+/*
+ * Billing events, called when a VM is started or terminated
+ */
+void billing_start_VM(sg_host_t);
+void billing_terminate_VM(sg_host_t);
+
+/*
+ * Budget ledger
+ */
+double get_consumed_budget();
+double get_committed_budget();
+double sg_host_get_total_cost(sg_host_t);
+int sg_host_get_billed_hours(sg_host_t);
+
+/* Other functions needed by scheduling algorithms */
+xbt_dynar_t get_ending_billing_cycle_VMs(double, double);
+double get_next_billing_boundary(double);
+
+#endif /* BILLING_H_ */
@@ -0,0 +1,29 @@
+/*
+ * Copyright (c) Centre de Calcul de l'IN2P3 du CNRS
+ * Contributor(s) : Frédéric SUTER (2012-2016)
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the license (GNU LGPL) which comes with this package.
+ */
+
+#ifndef CLOUD_H_
+#define CLOUD_H_
+#include "scheduling.h"
+
+/* Compact description of a cloud: a pool of identical VMs connected by a backbone. It replaces a platform file whose
+ * size would have to match the worst case.
+ */
+typedef struct _CloudSpec *CloudSpec;
+struct _CloudSpec {
+  double speed;   /* VM type: speed of a VM in flop/s */
+  int count;      /* maximum number of VMs in the pool */
+  double bw;      /* bandwidth (B/s) and latency (s) of the link of a VM */
+  double lat;
+  double bb_bw;   /* bandwidth (B/s) and latency (s) of the backbone */
+  double bb_lat;
+};
+
+void parse_cloud_spec(const char *, CloudSpec);
+int get_cloud_pool_size(CloudSpec, xbt_dynar_t);
+void create_cloud_environment(CloudSpec, int);
+
+#endif /* CLOUD_H_ */
@@ -9,10 +9,44 @@
 #define DAX_H_
 #include "scheduling.h"
 
+/* Descriptor of a DAX, shared by all its tasks that only store the index of the descriptor in a global table */
+typedef struct _DaxDescriptor *DaxDescriptor;
+struct _DaxDescriptor {
+  char *name;
+  int priority;
+  SD_task_t root;
+  SD_task_t end;
+  int ntasks;             /* compute and transfer tasks (compute tasks only if transfers are folded, see workflow.h) */
+  int ncompute_tasks;
+  int ncompleted_tasks;   /* compute tasks that are done */
+  int completed;          /* 1 once the end task is done, or is known to be done (see dax_is_completed) */
+  double remaining_work;  /* amount of computation of the compute tasks that are not done yet (in flops) */
+  double critical_path;   /* amount of computation along the longest path from the root to the end task (in flops) */
+  double shortest_path;   /* least amount of computation done before the end task can be scheduled (in flops) */
+  int admitted;           /* 1 once the DAX has passed the admission control of WA-DPDS */
+  int end_scheduled;      /* 1 once the end task is scheduled, the DAX is then bound to complete */
+  int doomed;             /* 1 once the end task is known not to be scheduled before the deadline */
+  SD_task_t *compute_graph; /* array holding the compute-only dependency graph (see set_compute_graph) */
+  double *edge_sizes;     /* array holding the sizes of the data sent through the edges of this graph */
+  xbt_dynar_t tasks;      /* NULL once the tasks have been released */
+};
+
+int register_dax(xbt_dynar_t dax, const char *name);
+DaxDescriptor get_dax_descriptor(int id);
+int get_number_of_daxes();
+int get_peak_number_of_live_daxes();
+int dax_is_completed(int id);
+void release_dax(int id);
+void free_dax_descriptors();
+
 SD_task_t get_root(xbt_dynar_t dax);
 SD_task_t get_end(xbt_dynar_t dax);
 
+void build_compute_graph(xbt_dynar_t dax);
+void set_compute_graph(xbt_dynar_t dax, const int *offsets, const int *children, const double *sizes);
+void free_compute_graph(xbt_dynar_t dax);
+
 void assign_dax_priorities(xbt_dynar_t, method_t);
-double compute_score(xbt_dynar_t);
+double compute_score();
 
 #endif /* DAX_H_ */
@@ -0,0 +1,40 @@
+/*
+ * Copyright (c) Centre de Calcul de l'IN2P3 du CNRS
+ * Contributor(s) : Frédéric SUTER (2012-2016)
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the license (GNU LGPL) which comes with this package.
+ */
+
+#ifndef ENGINE_H_
+#define ENGINE_H_
+#include "simgrid/simdag.h"
+
+/* Simulation engines used by DPDS and WA-DPDS. SimGrid simulates the execution of the tasks and of the transfers on the
+ * platform. The native engine only handles the model of these algorithms: one task at a time per VM at a fixed speed,
+ * and transfers that take the time they would take on an idle network. It replaces the SimGrid kernel by an event queue
+ * while the platform, the tasks and the dependencies are still described by SimGrid objects. When no network contention
+ * is modeled (--network none), its decisions and results are identical to those of SimGrid, which bench/check_engine.sh
+ * verifies on the shipped DAXes. Under the full network model, transfers do not contend with each other.
+ */
+typedef enum {
+  ENGINE_SIMGRID=0,
+  ENGINE_NATIVE
+} engine_type_t;
+
+void engine_init(engine_type_t, int);
+void engine_exit();
+engine_type_t engine_get_type();
+engine_type_t getEngineByName(const char *);
+
+/* Counterparts of SD_get_clock, SD_simulate and SD_task_schedulel (that also handles the resource dependencies) */
+double engine_get_clock();
+xbt_dynar_t engine_simulate(double);
+void engine_schedule(SD_task_t, sg_host_t);
+
+/* Accessors to the execution of a compute task */
+e_SD_task_state_t engine_task_get_state(SD_task_t);
+sg_host_t engine_task_get_host(SD_task_t);
+double engine_task_get_start_time(SD_task_t);
+double engine_task_get_finish_time(SD_task_t);
+
+#endif /* ENGINE_H_ */
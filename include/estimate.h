@@ -0,0 +1,26 @@
+/*
+ * Copyright (c) Centre de Calcul de l'IN2P3 du CNRS
+ * Contributor(s) : Frédéric SUTER (2012-2016)
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the license (GNU LGPL) which comes with this package.
+ */
+
+#ifndef ESTIMATE_H_
+#define ESTIMATE_H_
+#include "scheduling.h"
+
+/* Conservative bounds of the main figures of a simulation, computed from the loaded DAXes and the platform without
+ * simulating (offline mode only). Every simulation of the same configuration is within these bounds.
+ */
+typedef struct _estimate *estimate_t;
+struct _estimate {
+  double max_score;         /* upper bound of the score */
+  int max_completed_daxes;  /* upper bound of the number of completed DAXes */
+  double min_cost;          /* lower bound of the total cost */
+  double min_makespan;      /* lower bound of the makespan */
+};
+
+void estimate_simulation(scheduling_globals_t, estimate_t);
+int check_estimate(estimate_t, simulation_result_t);
+
+#endif /* ESTIMATE_H_ */
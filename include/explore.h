@@ -0,0 +1,29 @@
+/*
+ * Copyright (c) Centre de Calcul de l'IN2P3 du CNRS
+ * Contributor(s) : Frédéric SUTER (2012-2016)
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the license (GNU LGPL) which comes with this package.
+ */
+
+#ifndef EXPLORE_H_
+#define EXPLORE_H_
+#include "scheduling.h"
+
+/* What-if exploration of provisioning policies. The simulation runs with the policy given on the command line until
+ * a branching point, i.e., a provisioning period. There, the process forks one branch per variant of the policy, and
+ * each branch continues the simulation from the same state with its own policy.
+ */
+typedef struct _PolicyVariant {
+  double at;      /* time from which the variant applies, i.e., first provisioning period at or after it */
+  double period;
+  double uh;
+  double ul;
+} PolicyVariant;
+
+void explore_read_variants(const char *, scheduling_globals_t, int);
+int explore_branch_point(scheduling_globals_t);
+double explore_next_branch_time();
+int explore_is_branch();
+void explore_report(simulation_result_t);
+
+#endif /* EXPLORE_H_ */
@@ -9,6 +9,13 @@
 #define HOST_H_
 #include "simgrid/simdag.h"
 
+/* States of a host/VM. Each host belongs to the set of hosts of its current state */
+typedef enum {
+  VM_OFF=0,
+  VM_IDLE,
+  VM_BUSY
+} vm_state_t;
+
 typedef struct _HostAttribute *HostAttribute;
 struct _HostAttribute {
   /* Earliest time at which a host is ready to execute a task*/
@@ -17,20 +24,27 @@ struct _HostAttribute {
   int on_off;     /* 1 = ON, 0 = OFF */
   int idle_busy;  /* 1 = Busy, 0 = idle */
   double start_time;
+  int set_index;  /* position of the host in the set of its current state */
+  /* slot and neighbors of the host in the billing cycle wheel (see billing.c) */
+  int wheel_slot;
+  sg_host_t wheel_prev;
+  sg_host_t wheel_next;
 
   double price;
   double provisioning_delay;
-  double total_cost;
+  double total_cost; /* all the charges booked for this host (see billing.c) */
+  int billed_hours;  /* hours charged since the last start of the VM */
 
   SD_task_t booting;
+  double booted_at;  /* end of the boot of the VM, used by the native engine instead of the booting task */
   //TODO add necessary attributes
 };
 
 /*
  * Creator and destructor
  */
-void sg_host_allocate_attribute(sg_host_t );
-void sg_host_free_attribute(sg_host_t );
+void sg_host_allocate_attributes(const sg_host_t *, int);
+void sg_host_free_attributes(const sg_host_t *, int);
 
 /*
  * Accessors
@@ -53,12 +67,16 @@ int nameCompareHosts(const void *, const void *);
 
 /* Other functions needed by scheduling algorithms */
 int is_on_and_idle(sg_host_t);
+int get_number_of_idle_VMs();
+int get_number_of_running_VMs();
 xbt_dynar_t get_idle_VMs();
+xbt_dynar_t get_busy_VMs();
 xbt_dynar_t get_running_VMs();
-xbt_dynar_t get_ending_billing_cycle_VMs(double, double);
 xbt_dynar_t find_active_VMs_to_stop(int, xbt_dynar_t);
 sg_host_t find_inactive_VM_to_start();
+int get_number_of_failed_VM_starts();
 double compute_current_VM_utilization();
-sg_host_t select_random(xbt_dynar_t);
+sg_host_t select_random_idle_VM();
+sg_host_t select_local_idle_VM(SD_task_t);
 
 #endif /* HOST_H_ */
@@ -0,0 +1,43 @@
+/*
+ * Copyright (c) Centre de Calcul de l'IN2P3 du CNRS
+ * Contributor(s) : Frédéric SUTER (2012-2016)
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the license (GNU LGPL) which comes with this package.
+ */
+
+#ifndef QUEUE_H_
+#define QUEUE_H_
+#include "simgrid/simdag.h"
+
+/* Ready queue of compute tasks, implemented as an indexed binary max-heap. The position of a task in the heap is
+ * stored in its attribute, which gives a constant time membership test and allows for a task to be found without
+ * scanning the queue.
+ */
+typedef struct _ReadyQueue *ready_queue_t;
+struct _ReadyQueue {
+  SD_task_t *tasks;
+  int size;
+  int capacity;
+  unsigned long next_seq; /* insertion counter, used as secondary key */
+};
+
+/*
+ * Creator and destructor
+ */
+ready_queue_t ready_queue_new(int);
+void ready_queue_free(ready_queue_t *);
+
+/*
+ * Accessors
+ */
+int ready_queue_length(ready_queue_t);
+int ready_queue_is_empty(ready_queue_t);
+SD_task_t ready_queue_get(ready_queue_t, int);
+
+/*
+ * Queue operations
+ */
+void ready_queue_push(ready_queue_t, SD_task_t);
+SD_task_t ready_queue_pop(ready_queue_t);
+
+#endif /* QUEUE_H_ */
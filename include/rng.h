@@ -0,0 +1,28 @@
+/*
+ * Copyright (c) Centre de Calcul de l'IN2P3 du CNRS
+ * Contributor(s) : Frédéric SUTER (2012-2016)
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the license (GNU LGPL) which comes with this package.
+ */
+
+#ifndef RNG_H_
+#define RNG_H_
+#include <stdint.h>
+
+/* Independent random streams, one per component that draws random numbers. Drawing more numbers in one component
+ * thus never changes the numbers drawn by the others.
+ */
+typedef enum {
+  RNG_PRIORITIES=0,  /* RANDOM priorities of the DAXes (see dax.c) */
+  RNG_VM_SELECTION,  /* selection of an idle VM (see host.c) */
+  RNG_ARRIVALS,      /* Poisson arrivals of workflows (see arrival.c) */
+  RNG_NSTREAMS
+} rng_stream_t;
+
+void rng_seed(uint64_t);
+uint64_t rng_replication_seed(uint64_t, int);
+uint64_t rng_next(rng_stream_t);
+double rng_uniform(rng_stream_t);
+unsigned long rng_uniform_int(rng_stream_t, unsigned long);
+
+#endif /* RNG_H_ */
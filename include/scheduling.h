@@ -40,6 +40,24 @@ struct _scheduling_globals {
   /* time before a started VM actually becomes available */
   double provisioning_delay;
   int nVM;            /* Number of VMs that have been initially started */
+
+  int fast_forward;   /* 1 to skip the provisioning periods in which nothing can change (DPDS) */
+  unsigned long long seed; /* seed of the random streams (see rng.h) */
+  int early_abort;    /* 1 to stop as soon as no more DAX can complete (DPDS) */
+  int locality;       /* 1 to skip the transfers between tasks executed on the same VM, and to favor such placements */
+};
+
+/* Main figures of a simulation run */
+typedef struct _simulation_result *simulation_result_t;
+struct _simulation_result {
+  double makespan;
+  int completed_daxes;
+  int ndaxes;
+  double total_cost;
+  double score;
+  double wall_time;         /* time spent in the scheduling algorithm, in seconds */
+  unsigned long nevents;    /* task completions and wake-ups of the scheduler (see count_wakeup) */
+  int aborted;              /* 1 if the run stopped early (--early-abort): makespan and cost are those at that time */
 };
 
 scheduling_globals_t new_scheduling_globals();
@@ -48,11 +66,18 @@ char* getAlgorithmName(alg_t);
 alg_t getAlgorithmByName(char*);
 
 void handle_resource_dependency(sg_host_t, SD_task_t);
+void handle_local_transfers(sg_host_t, SD_task_t, sg_host_t (*)(SD_task_t));
+void run_simulation(xbt_dynar_t, scheduling_globals_t, simulation_result_t);
+void count_wakeup();
+void report_early_abort();
+void print_simulation_result(simulation_result_t);
+double get_wall_time();
 
 /*****************************************************************************/
 /*************       Scheduling algorithms entry points        ***************/
 /*****************************************************************************/
 void dpds(xbt_dynar_t, scheduling_globals_t);
-double compute_budget_consumption();
+int dpds_initial_VMs(scheduling_globals_t);
+void spss(xbt_dynar_t, scheduling_globals_t);
 
 #endif /* SCHEDULING_H_ */
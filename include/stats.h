@@ -0,0 +1,50 @@
+/*
+ * Copyright (c) Centre de Calcul de l'IN2P3 du CNRS
+ * Contributor(s) : Frédéric SUTER (2012-2016)
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the license (GNU LGPL) which comes with this package.
+ */
+
+#ifndef STATS_H_
+#define STATS_H_
+
+/* Instrumentation of the hot path of the schedulers, to know where the wall time of a run goes (in SimGrid or in the
+ * scheduling logic). It is only built when ENABLE_STATS is defined ('make STATS=1'). Otherwise, all the STATS_ macros
+ * expand to nothing.
+ */
+typedef enum {
+  STATS_SIMULATE=0,     /* calls to SD_simulate */
+  STATS_COMPLETION,     /* handling of completed tasks */
+  STATS_SCHEDULING,     /* mapping of ready tasks on idle VMs */
+  STATS_PROVISIONING,   /* start and termination of VMs */
+  STATS_NPHASES
+} stats_phase_t;
+
+typedef enum {
+  STATS_TASKS_PER_WAKEUP=0,
+  STATS_QUEUE_LENGTH,
+  STATS_IDLE_VMS,
+  STATS_NHISTOGRAMS
+} stats_histogram_t;
+
+/* Histograms have power-of-two buckets: 0, 1, 2-3, 4-7, ... */
+#define STATS_NBUCKETS 32
+
+void stats_start(stats_phase_t);
+void stats_stop(stats_phase_t);
+void stats_record(stats_histogram_t, unsigned long);
+void stats_report();
+
+#ifdef ENABLE_STATS
+#  define STATS_START(phase) stats_start(phase)
+#  define STATS_STOP(phase) stats_stop(phase)
+#  define STATS_RECORD(histogram, value) stats_record(histogram, value)
+#  define STATS_REPORT() stats_report()
+#else
+#  define STATS_START(phase) do {} while (0)
+#  define STATS_STOP(phase) do {} while (0)
+#  define STATS_RECORD(histogram, value) do {} while (0)
+#  define STATS_REPORT() do {} while (0)
+#endif
+
+#endif /* STATS_H_ */
@@ -0,0 +1,50 @@
+/*
+ * Copyright (c) Centre de Calcul de l'IN2P3 du CNRS
+ * Contributor(s) : Frédéric SUTER (2012-2016)
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the license (GNU LGPL) which comes with this package.
+ */
+
+#ifndef SWEEP_H_
+#define SWEEP_H_
+#include <sys/types.h>
+#include "scheduling.h"
+
+/* Pool of forked worker processes. Each worker runs one simulation from the state of the parent process at the time of
+ * the fork (platform and DAXes already loaded), which is shared in a copy-on-write way, and sends its result back to
+ * the parent through a pipe.
+ */
+typedef struct _worker_pool *worker_pool_t;
+struct _worker_pool {
+  int max_workers;
+  int nworkers;
+  pid_t *pids;
+  int *pipes;        /* read end of the pipe of each running worker */
+  int *jobs;         /* identifier of the job run by each running worker */
+};
+
+/*
+ * Creator and destructor
+ */
+worker_pool_t worker_pool_new(int);
+void worker_pool_free(worker_pool_t *);
+
+/*
+ * Pool management
+ */
+int worker_pool_is_full(worker_pool_t);
+int worker_pool_is_empty(worker_pool_t);
+int worker_pool_fork(worker_pool_t, int);
+void worker_pool_report(simulation_result_t);
+int worker_pool_wait(worker_pool_t, int *, simulation_result_t);
+int get_number_of_cores();
+
+/* Parameter sweep driver */
+xbt_dynar_t read_sweep_configurations(const char *, scheduling_globals_t);
+void run_sweep(xbt_dynar_t, scheduling_globals_t, const char *, int);
+void run_estimate_sweep(xbt_dynar_t, scheduling_globals_t, const char *);
+
+/* Monte-Carlo replications driver */
+void run_replications(xbt_dynar_t, scheduling_globals_t, int, int);
+
+#endif /* SWEEP_H_ */
@@ -11,24 +11,60 @@
 
 typedef struct _TaskAttribute *TaskAttribute;
 struct _TaskAttribute {
-  char *daxname;
-  int dax_priority;
+  int dax_id;     /* index of the DAX the task belongs to in the table of DAX descriptors (see dax.c) */
+  int dax_index;  /* position of the task in its DAX */
+
+  /* Position in the ready queue (-1 if not queued) and insertion rank, used by queue.c */
+  int queue_index;
+  unsigned long queue_seq;
+
+  /* Compute-only dependency graph, in which transfers are folded in (see build_compute_graph in dax.c). Adjacency
+   * lists are slices of a single array per DAX.
+   */
+  SD_task_t *children;
+  int nchildren;
+  SD_task_t *parents;
+  int nparents;
+  /* Largest amount of data sent through each edge (in bytes), parallel to the children and parents lists. It is -1 for
+   * a control dependency.
+   */
+  double *output_sizes;
+  double *input_sizes;
+  int pending_parents; /* number of compute parents that are not scheduled yet */
+  /* Least amount of computation (in flops) that has to be done once the task is done before the end task of its DAX
+   * can be scheduled (see set_path_bounds in dax.c)
+   */
+  double path_to_end;
+
+  /* Execution of the task by the native engine (see engine.c) */
+  e_SD_task_state_t state;
+  int unfinished_parents; /* number of compute parents that are not done yet */
+  sg_host_t host;
+  double scheduled_at;
+  double start_time;
+  double finish_time;
   //TODO add necessary attributes
 };
 
 /*
  * Creator and destructor
  */
-void SD_task_allocate_attribute(SD_task_t);
-void SD_task_free_attribute(SD_task_t);
+void SD_task_allocate_attributes(xbt_dynar_t);
+void SD_task_free_attributes(xbt_dynar_t);
 
 /*
  * Accessors
  */
-void SD_task_set_dax_name(SD_task_t, char*);
+int SD_task_get_dax_id(SD_task_t);
+int SD_task_get_dax_index(SD_task_t);
 char* SD_task_get_dax_name(SD_task_t);
-void SD_task_set_dax_priority(SD_task_t, int);
 int SD_task_get_dax_priority(SD_task_t);
+int SD_task_is_queued(SD_task_t);
+int SD_task_get_compute_children_count(SD_task_t);
+SD_task_t *SD_task_get_compute_children(SD_task_t);
+int SD_task_get_compute_parents_count(SD_task_t);
+SD_task_t *SD_task_get_compute_parents(SD_task_t);
+double SD_task_get_path_to_end(SD_task_t);
 
 /*
  * Comparators
@@ -36,6 +72,7 @@ int SD_task_get_dax_priority(SD_task_t);
 int daxPriorityCompareTasks(const void *, const void *);
 
 /* Other functions needed by scheduling algorithms */
-xbt_dynar_t SD_task_get_ready_children(SD_task_t t);
+int SD_task_is_ready(SD_task_t);
+void SD_task_release_children(SD_task_t);
 
 #endif /* TASK_H_ */
@@ -0,0 +1,59 @@
+/*
+ * Copyright (c) Centre de Calcul de l'IN2P3 du CNRS
+ * Contributor(s) : Frédéric SUTER (2012-2016)
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the license (GNU LGPL) which comes with this package.
+ */
+
+#ifndef TRACE_H_
+#define TRACE_H_
+#include <stdint.h>
+#include "simgrid/simdag.h"
+
+#define TRACE_MAGIC "ESTRACE"
+#define TRACE_VERSION 1
+/* Size of the in-memory buffer. Events are written to the file by batches of this size */
+#define TRACE_BUFFER_SIZE (1 << 20)
+
+typedef enum {
+  TRACE_CSV=0,
+  TRACE_BINARY
+} trace_format_t;
+
+typedef enum {
+  TRACE_TASK_START=0,
+  TRACE_TASK_END,
+  TRACE_VM_START,
+  TRACE_VM_TERMINATE,
+  TRACE_PERIOD
+} trace_event_t;
+
+/* Layout of the binary trace:
+ * - a header: TRACE_MAGIC (8 bytes), version, number of VMs, and number of DAXes (uint32_t)
+ * - the names of the VMs then the names of the DAXes (in loading order), as null-terminated strings. VMs and DAXes
+ *   are referred to by their rank in these lists.
+ * - a sequence of fixed size records. A task is identified by the DAX it belongs to and its position in this DAX (i.e.,
+ *   in the DAX file). Fields that are not meaningful for an event are set to -1.
+ */
+typedef struct _trace_record {
+  double time;
+  double utilization;     /* TRACE_PERIOD only */
+  double consumed_budget; /* TRACE_PERIOD only */
+  int32_t event;
+  int32_t vm;
+  int32_t dax;
+  int32_t task;
+} trace_record_t;
+
+void trace_open(const char *, trace_format_t);
+void trace_close();
+
+/*
+ * Events. They do nothing if no trace is open.
+ */
+void trace_task(SD_task_t);
+void trace_VM_start(sg_host_t);
+void trace_VM_terminate(sg_host_t);
+void trace_period(double, double);
+
+#endif /* TRACE_H_ */
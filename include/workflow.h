@@ -0,0 +1,38 @@
+/*
+ * Copyright (c) Centre de Calcul de l'IN2P3 du CNRS
+ * Contributor(s) : Frédéric SUTER (2012-2016)
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the license (GNU LGPL) which comes with this package.
+ */
+
+#ifndef WORKFLOW_H_
+#define WORKFLOW_H_
+#include "simgrid/simdag.h"
+
+/* Version of the binary format of parsed DAXes. Has to be increased each time this format changes. */
+#define WORKFLOW_IMAGE_VERSION 2
+
+/* Network model under which DAXes are loaded:
+ * - FULL: transfers are SimDAG tasks, simulated as such.
+ * - LATENCY: transfers are not built. The edges of the compute-only graph become control dependencies that keep the
+ *   size of the data they carry, for the native engine to delay each task by latency + size/bandwidth.
+ * - NONE: transfers are not built either, and take no time.
+ * In the last two models, DAXes only hold their compute tasks, the root first and the end task last.
+ */
+typedef enum {
+  NETWORK_FULL=0,
+  NETWORK_LATENCY,
+  NETWORK_NONE
+} network_model_t;
+
+void set_network_model(network_model_t);
+network_model_t getNetworkModelByName(const char *);
+
+/* Load an instance of a DAX file, i.e., build its SimDAG tasks, allocate their attributes and build the compute-only
+ * dependency graph. Each file is parsed only once. If a cache directory is given, the parsed DAX is read from or
+ * written to it.
+ */
+xbt_dynar_t load_dax(const char *, const char *, const char *);
+void free_dax_templates();
+
+#endif /* WORKFLOW_H_ */
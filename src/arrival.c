@@ -0,0 +1,195 @@
+/*
+ * Copyright (c) Centre de Calcul de l'IN2P3 du CNRS
+ * Contributor(s) : Frédéric SUTER (2012-2016)
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the license (GNU LGPL) which comes with this package.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+#include "xbt.h"
+#include "simgrid/simdag.h"
+#include "dax.h"
+#include "task.h"
+#include "workflow.h"
+#include "arrival.h"
+#include "rng.h"
+
+XBT_LOG_NEW_DEFAULT_SUBCATEGORY(arrival, EnsembleSched, "Logging specific to workflow arrivals");
+
+/* Arrivals sorted by increasing time, and rank of the next one. DAXes are only loaded when they arrive, from the
+ * templates kept by workflow.c, so that each file is parsed only once whatever the number of arrivals.
+ */
+static xbt_dynar_t arrivals = NULL;
+static unsigned int next_arrival = 0;
+static const char *cache_dir = NULL;
+
+/* Parameters of the Poisson process, kept to draw the arrivals again (see arrivals_redraw) */
+static double poisson_rate = 0.;
+static double poisson_horizon = 0.;
+static xbt_dynar_t poisson_files = NULL;
+
+static int timeCompareArrivals(const void *a1, const void *a2){
+  double t1 = ((const Arrival *) a1)->time;
+  double t2 = ((const Arrival *) a2)->time;
+
+  if (t1 < t2)
+    return -1;
+  else if (t1 == t2)
+    return 0;
+  else
+    return 1;
+}
+
+static void add_arrival(double time, const char *filename, int drawn){
+  Arrival arrival;
+
+  if (!arrivals)
+    arrivals = xbt_dynar_new(sizeof(Arrival), NULL);
+  arrival.time = time;
+  arrival.filename = xbt_strdup(filename);
+  arrival.drawn = drawn;
+  xbt_dynar_push(arrivals, &arrival);
+}
+
+/* Read an arrival trace. Each non empty line (apart from comments starting by '#') gives the arrival time of a
+ * workflow in seconds and the DAX file that describes it, e.g.,
+ *   3600 daxfiles/Montage_50.xml
+ */
+void arrivals_read_trace(const char *filename){
+  char line[4096], file[4096];
+  double time;
+  int line_number = 0;
+  FILE *f = fopen(filename, "r");
+
+  if (!f)
+    xbt_die("Cannot open the arrival trace %s", filename);
+
+  while (fgets(line, sizeof(line), f)){
+    line_number++;
+    if (strchr(line, '#'))
+      *strchr(line, '#') = '\0';
+    if (sscanf(line, "%lf %4095s", &time, file) != 2){
+      if (strspn(line, " \t\r\n") != strlen(line))
+        xbt_die("%s:%d: expected '<time> <DAX file>'", filename, line_number);
+      continue;
+    }
+    add_arrival(time, file, 0);
+  }
+  fclose(f);
+  /* The trace may not be sorted, and may be combined with other arrivals */
+  if (arrivals)
+    xbt_dynar_sort(arrivals, timeCompareArrivals);
+}
+
+static void draw_poisson_arrivals(){
+  double time = 0.;
+  char *filename;
+
+  while (1){
+    time -= log(1. - rng_uniform(RNG_ARRIVALS)) * 3600. / poisson_rate;
+    if (time > poisson_horizon)
+      break;
+    xbt_dynar_get_cpy(poisson_files, rng_uniform_int(RNG_ARRIVALS, xbt_dynar_length(poisson_files)), &filename);
+    add_arrival(time, filename, 1);
+  }
+  if (arrivals)
+    xbt_dynar_sort(arrivals, timeCompareArrivals);
+}
+
+/* Generate arrivals following a Poisson process of a given rate (in workflows per hour) until a given horizon. Each
+ * arriving workflow is drawn uniformly among the given DAX files.
+ */
+void arrivals_generate_poisson(double rate, double horizon, xbt_dynar_t files){
+  unsigned int i;
+  char *filename;
+
+  xbt_assert(rate > 0 && !xbt_dynar_is_empty(files), "Poisson arrivals need a positive rate and some DAX files");
+
+  poisson_rate = rate;
+  poisson_horizon = horizon;
+  poisson_files = xbt_dynar_new(sizeof(char*), NULL);
+  xbt_dynar_foreach(files, i, filename){
+    filename = xbt_strdup(filename);
+    xbt_dynar_push(poisson_files, &filename);
+  }
+  draw_poisson_arrivals();
+}
+
+/* Draw the Poisson arrivals again from the current state of their random stream, e.g., in a new replication. The
+ * arrivals read from a trace are kept. Has to be called before any workflow has arrived.
+ */
+void arrivals_redraw(){
+  unsigned int i = 0;
+  Arrival *arrival;
+
+  if (!poisson_files)
+    return;
+  xbt_assert(!next_arrival, "Arrivals cannot be drawn again once the simulation has started");
+  while (i < xbt_dynar_length(arrivals)){
+    arrival = (Arrival *) xbt_dynar_get_ptr(arrivals, i);
+    if (arrival->drawn){
+      free(arrival->filename);
+      xbt_dynar_remove_at(arrivals, i, NULL);
+    } else {
+      i++;
+    }
+  }
+  draw_poisson_arrivals();
+}
+
+void arrivals_set_cache_dir(const char *dir){
+  cache_dir = dir;
+}
+
+int get_number_of_arrivals(){
+  return arrivals ? xbt_dynar_length(arrivals) : 0;
+}
+
+int get_number_of_pending_arrivals(){
+  return get_number_of_arrivals() - next_arrival;
+}
+
+/* Time of the next arrival, or DBL_MAX if every workflow has already arrived */
+double get_next_arrival_time(){
+  if (!get_number_of_pending_arrivals())
+    return DBL_MAX;
+  return ((Arrival *) xbt_dynar_get_ptr(arrivals, next_arrival))->time;
+}
+
+/* Load the DAX of the next arrival. Each arrival is named after its file and its rank, e.g., Montage_50.xml@3. The
+ * earlier a workflow arrives, the higher its priority, so that workflows are served in their order of arrival.
+ */
+xbt_dynar_t load_next_arrival(){
+  Arrival *arrival = (Arrival *) xbt_dynar_get_ptr(arrivals, next_arrival);
+  char *daxname = bprintf("%s@%u", arrival->filename, next_arrival + 1);
+  xbt_dynar_t dax = load_dax(arrival->filename, cache_dir, daxname);
+
+  get_dax_descriptor(SD_task_get_dax_id(get_root(dax)))->priority = get_number_of_arrivals() - next_arrival;
+  XBT_VERB("%s arrives", daxname);
+  free(daxname);
+  next_arrival++;
+
+  return dax;
+}
+
+void free_arrivals(){
+  unsigned int i;
+  Arrival arrival;
+  char *filename;
+
+  if (arrivals){
+    xbt_dynar_foreach(arrivals, i, arrival)
+      free(arrival.filename);
+    xbt_dynar_free(&arrivals);
+  }
+  next_arrival = 0;
+
+  if (poisson_files){
+    xbt_dynar_foreach(poisson_files, i, filename)
+      free(filename);
+    xbt_dynar_free(&poisson_files);
+  }
+}
@@ -0,0 +1,220 @@
+/*
+ * Copyright (c) Centre de Calcul de l'IN2P3 du CNRS
+ * Contributor(s) : Frédéric SUTER (2012-2016)
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the license (GNU LGPL) which comes with this package.
+ */
+#include <math.h>
+#include <float.h>
+#include "xbt.h"
+#include "simgrid/simdag.h"
+#include "host.h"
+#include "billing.h"
+#include "engine.h"
+
+XBT_LOG_NEW_DEFAULT_SUBCATEGORY(billing, EnsembleSched, "Logging specific to billing");
+
+/*****************************************************************************/
+/*****************************************************************************/
+/**************              Billing cycle wheel                **************/
+/*****************************************************************************/
+/*****************************************************************************/
+
+/* A running VM reaches a billing boundary every hour after its start time. The position of these boundaries within
+ * the hour, i.e., the start time modulo 3600s, thus never changes while the VM is running. The wheel has one slot per
+ * second of the hour and each slot holds the (doubly linked) list of the running VMs whose boundaries fall in it.
+ * Finding the VMs that approach the end of a paid hour then amounts to visiting the few slots that precede the current
+ * time in the hour, independently of the size of the pool.
+ */
+static sg_host_t wheel[BILLING_CYCLE];
+
+static int get_wheel_slot(double time){
+  int slot = (int) fmod(time, BILLING_CYCLE);
+
+  /* guard against rounding errors */
+  return (slot < 0 || slot >= BILLING_CYCLE) ? 0 : slot;
+}
+
+/* Add a VM to the wheel. Has to be called when the VM is started, once its start time is set. */
+static void billing_wheel_insert(sg_host_t host){
+  HostAttribute attr = (HostAttribute) sg_host_user(host);
+
+  attr->wheel_slot = get_wheel_slot(attr->start_time);
+  attr->wheel_prev = NULL;
+  attr->wheel_next = wheel[attr->wheel_slot];
+  if (attr->wheel_next)
+    ((HostAttribute) sg_host_user(attr->wheel_next))->wheel_prev = host;
+  wheel[attr->wheel_slot] = host;
+}
+
+/* Remove a VM from the wheel. Has to be called when the VM is terminated. */
+static void billing_wheel_remove(sg_host_t host){
+  HostAttribute attr = (HostAttribute) sg_host_user(host);
+
+  if (attr->wheel_prev)
+    ((HostAttribute) sg_host_user(attr->wheel_prev))->wheel_next = attr->wheel_next;
+  else
+    wheel[attr->wheel_slot] = attr->wheel_next;
+  if (attr->wheel_next)
+    ((HostAttribute) sg_host_user(attr->wheel_next))->wheel_prev = attr->wheel_prev;
+  attr->wheel_prev = NULL;
+  attr->wheel_next = NULL;
+}
+
+/*****************************************************************************/
+/*****************************************************************************/
+/**************                 Budget ledger                   **************/
+/*****************************************************************************/
+/*****************************************************************************/
+
+/* The ledger books the charges of VMs as events instead of recomputing the cost of every host:
+ * - the first hour is charged when a VM is started;
+ * - an extra hour is charged each time a running VM reaches one of its billing boundaries (accrual);
+ * - the hours that have not been charged yet are settled when a VM is terminated.
+ * A VM that ran for d seconds is thus charged for 1 + floor(d/3600) hours.
+ * Accruals are booked lazily, when the ledger is consulted. Only the VMs in the slots of the wheel between the last
+ * consultation and the current time can have reached a billing boundary in the meantime.
+ */
+static double consumed_budget = 0.0; /* sum of all the charges booked so far */
+static double running_price = 0.0;   /* sum of the hourly prices of running VMs */
+static double ledger_time = 0.0;     /* date up to which accruals have been booked */
+
+/* Charge a VM for the hours it started since its last start that have not been charged yet */
+static void charge_due_hours(sg_host_t host, double now){
+  HostAttribute attr = (HostAttribute) sg_host_user(host);
+  int due_hours = 1 + ((int)(now - attr->start_time))/BILLING_CYCLE;
+
+  if (due_hours > attr->billed_hours){
+    XBT_DEBUG("%s : Account for %d more hour(s)", sg_host_get_name(host), due_hours - attr->billed_hours);
+    attr->total_cost += (due_hours - attr->billed_hours)*attr->price;
+    consumed_budget += (due_hours - attr->billed_hours)*attr->price;
+    attr->billed_hours = due_hours;
+  }
+}
+
+/* Book the accruals of all the VMs that reached a billing boundary since the last call */
+static void ledger_update(){
+  int i, nslots;
+  double now = engine_get_clock();
+  sg_host_t host;
+
+  if (now <= ledger_time)
+    return;
+
+  /* visit the slots from the last consultation to now, plus one on each side to account for truncations */
+  nslots = (now - ledger_time) >= BILLING_CYCLE - 2 ? BILLING_CYCLE :
+      (get_wheel_slot(now) - get_wheel_slot(ledger_time) + BILLING_CYCLE) % BILLING_CYCLE + 3;
+  for (i = 0; i < nslots; i++)
+    for (host = wheel[(get_wheel_slot(ledger_time) - 1 + i + BILLING_CYCLE) % BILLING_CYCLE]; host;
+         host = ((HostAttribute) sg_host_user(host))->wheel_next)
+      charge_due_hours(host, now);
+
+  ledger_time = now;
+}
+
+/* Start event: the VM enters the wheel and its first hour is charged */
+void billing_start_VM(sg_host_t host){
+  HostAttribute attr = (HostAttribute) sg_host_user(host);
+
+  billing_wheel_insert(host);
+  attr->billed_hours = 1;
+  attr->total_cost += attr->price;
+  consumed_budget += attr->price;
+  running_price += attr->price;
+  XBT_DEBUG("VM started on %s: Total cost is now $%f for this host", sg_host_get_name(host), attr->total_cost);
+}
+
+/* Terminate event: final settlement of the VM, which then leaves the wheel */
+void billing_terminate_VM(sg_host_t host){
+  HostAttribute attr = (HostAttribute) sg_host_user(host);
+
+  charge_due_hours(host, engine_get_clock());
+  billing_wheel_remove(host);
+  running_price -= attr->price;
+  attr->billed_hours = 0;
+  XBT_DEBUG("VM stopped on %s: Total cost is now $%f for this host", sg_host_get_name(host), attr->total_cost);
+}
+
+/* Determine how much money has already been spent, i.e., the price of all the hours started by the VMs so far. */
+double get_consumed_budget(){
+  ledger_update();
+  return consumed_budget;
+}
+
+/* Determine how much money will have been spent once each running VM has reached its next billing boundary. */
+double get_committed_budget(){
+  ledger_update();
+  return consumed_budget + running_price;
+}
+
+/* Per-VM view of the ledger: total cost charged for a host so far */
+double sg_host_get_total_cost(sg_host_t host){
+  ledger_update();
+  return ((HostAttribute) sg_host_user(host))->total_cost;
+}
+
+/* Per-VM view of the ledger: hours charged since the last start of a VM (0 if it is not running) */
+int sg_host_get_billed_hours(sg_host_t host){
+  ledger_update();
+  return ((HostAttribute) sg_host_user(host))->billed_hours;
+}
+
+/*****************************************************************************/
+/*****************************************************************************/
+/**************    Functions needed by scheduling algorithms    **************/
+/*****************************************************************************/
+/*****************************************************************************/
+
+/* Build an array that contains all the hosts/VMs that are "approaching their hourly billing cycle" in the platform
+ * Remark: In the paper by Malawski et al., no details are provided about when a VM is "approaching" the end of a
+ * paid hour. This is hard coded in the source code of cloudworkflowsim: 90s (provisioner interval, a.k.a period) +
+ * 1s (optimistic deprovisioning delay)
+ */
+xbt_dynar_t get_ending_billing_cycle_VMs(double period, double margin){
+  int i, nslots, first_slot;
+  double now = engine_get_clock();
+  sg_host_t host;
+  HostAttribute attr;
+  xbt_dynar_t endingVMs = xbt_dynar_new(sizeof(sg_host_t), NULL);
+
+  /* To determine how far a VM is from the end of a hourly billing cycle, we compute the time spent between the start
+   * of the VM and the current, and keep the time spent in the last hour. As times are expressed in seconds, it amounts
+   * to computing the modulo to 3600s=1h. Then the current VM is selected if this modulo is greater than
+   * 3600-period-margin.
+   * Such VMs have a start time that lies in the period+margin seconds that follow the current time (modulo 3600s).
+   * Only the corresponding slots of the wheel, plus one on each side to account for truncations, are visited. The
+   * exact condition is then checked for each VM found in these slots.
+   */
+  first_slot = get_wheel_slot(now) - 1 + BILLING_CYCLE;
+  nslots = (int) ceil(period + margin) + 3;
+  if (nslots > BILLING_CYCLE)
+    nslots = BILLING_CYCLE;
+
+  for (i = 0; i < nslots; i++){
+    for (host = wheel[(first_slot + i) % BILLING_CYCLE]; host; host = attr->wheel_next){
+      attr = sg_host_user(host);
+      if (((int)(now - attr->start_time) % BILLING_CYCLE) > (BILLING_CYCLE-period-margin))
+        xbt_dynar_push(endingVMs, &host);
+    }
+  }
+
+  return endingVMs;
+}
+
+/* Lower bound of the earliest date, from now on, at which a running VM is 'lead' seconds away from one of its billing
+ * boundaries. Returns DBL_MAX if no VM is running.
+ * The wheel is scanned from the current slot. The first non-empty slot holds the VMs whose next boundary comes first,
+ * VMs that are already less than 'lead' seconds away from their boundary lead to the current date. A margin of two
+ * seconds accounts for truncations.
+ */
+double get_next_billing_boundary(double lead){
+  int i, first_slot;
+  double now = engine_get_clock();
+
+  first_slot = get_wheel_slot(now);
+  for (i = 0; i < BILLING_CYCLE; i++)
+    if (wheel[(first_slot + i) % BILLING_CYCLE])
+      return MAX(now, now + i - lead - 2);
+
+  return DBL_MAX;
+}
@@ -0,0 +1,128 @@
+/*
+ * Copyright (c) Centre de Calcul de l'IN2P3 du CNRS
+ * Contributor(s) : Frédéric SUTER (2012-2016)
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the license (GNU LGPL) which comes with this package.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <math.h>
+#include <unistd.h>
+#include "xbt.h"
+#include "simgrid/simdag.h"
+#include "cloud.h"
+
+XBT_LOG_NEW_DEFAULT_SUBCATEGORY(cloud, EnsembleSched, "Logging specific to cloud descriptions");
+
+/* Parse a value with an optional unit, e.g., 4.2Gf, 125MBps or 50us. Only the multiplier matters (n, u, m, k, M, G
+ * or T), the rest of the unit is ignored.
+ */
+static double parse_value(const char *key, const char *value){
+  char *end;
+  double v = strtod(value, &end);
+
+  if (end == value)
+    xbt_die("Invalid value for %s in the cloud description: %s", key, value);
+
+  switch (*end){
+  case 'n': return v * 1e-9;
+  case 'u': return v * 1e-6;
+  case 'm': return v * 1e-3;
+  case 'k': return v * 1e3;
+  case 'M': return v * 1e6;
+  case 'G': return v * 1e9;
+  case 'T': return v * 1e12;
+  default:  return v;
+  }
+}
+
+/* Parse a cloud description, i.e., a comma separated list of key=value pairs among speed, count, bw, lat, bb_bw and
+ * bb_lat, e.g.,
+ *   speed=4.2Gf,count=100000,bw=125MBps,lat=50us
+ * Parameters that are not set take the values of the cluster given as example (cluster.xml), and the size of the pool
+ * is not limited.
+ */
+void parse_cloud_spec(const char *description, CloudSpec spec){
+  char *copy = xbt_strdup(description), *token, *value, *saveptr;
+
+  spec->speed = 4.2e9;
+  spec->count = INT_MAX;
+  spec->bw = 1.25e8;
+  spec->lat = 5e-5;
+  spec->bb_bw = 2.25e9;
+  spec->bb_lat = 5e-4;
+
+  for (token = strtok_r(copy, ",", &saveptr); token; token = strtok_r(NULL, ",", &saveptr)){
+    value = strchr(token, '=');
+    if (!value)
+      xbt_die("'%s' is not a key=value pair in the cloud description", token);
+    *value++ = '\0';
+    if (!strcmp(token, "speed"))
+      spec->speed = parse_value(token, value);
+    else if (!strcmp(token, "count"))
+      spec->count = (int) parse_value(token, value);
+    else if (!strcmp(token, "bw"))
+      spec->bw = parse_value(token, value);
+    else if (!strcmp(token, "lat"))
+      spec->lat = parse_value(token, value);
+    else if (!strcmp(token, "bb_bw"))
+      spec->bb_bw = parse_value(token, value);
+    else if (!strcmp(token, "bb_lat"))
+      spec->bb_lat = parse_value(token, value);
+    else
+      xbt_die("Unknown parameter '%s' in the cloud description", token);
+  }
+  free(copy);
+
+  if (spec->speed <= 0 || spec->count < 1 || spec->bw <= 0 || spec->bb_bw <= 0)
+    xbt_die("Invalid cloud description: %s", description);
+}
+
+/* Size of the pool of VMs needed by a set of configurations (of type struct _scheduling_globals), i.e., the largest
+ * number of VMs that one of them may run at the same time:
+ * - as each started VM is charged at least one hour, no more than budget/price VMs can be paid for;
+ * - DPDS and WA-DPDS start new VMs as long as fewer than vmax times the initial number of VMs are running, without
+ *   checking the budget. This exceeds budget/price when vmax is larger than the number of hours before the deadline.
+ * The pool has at most count VMs.
+ */
+int get_cloud_pool_size(CloudSpec spec, xbt_dynar_t configurations){
+  unsigned int i;
+  double nVMs = 1;
+  scheduling_globals_t config;
+
+  for (i = 0; i < xbt_dynar_length(configurations); i++){
+    config = (scheduling_globals_t) xbt_dynar_get_ptr(configurations, i);
+    if (config->budget > 0 && config->price > 0)
+      nVMs = MAX(nVMs, MAX(ceil(config->budget / config->price), ceil(config->vmax * dpds_initial_VMs(config))));
+  }
+
+  return (int) MIN(nVMs, spec->count);
+}
+
+/* Create the SimGrid environment of a pool of n VMs. The pool is described by a single cluster in a temporary platform
+ * file, for which SimGrid builds neither one route per pair of hosts nor one element per host in the file.
+ */
+void create_cloud_environment(CloudSpec spec, int n){
+  char filename[] = "/tmp/EnsembleSched-cloud-XXXXXX.xml";
+  int fd = mkstemps(filename, 4);
+  FILE *f;
+
+  if (fd < 0 || !(f = fdopen(fd, "w")))
+    xbt_die("Cannot create a temporary platform file");
+
+  fprintf(f, "<?xml version='1.0'?>\n"
+          "<!DOCTYPE platform SYSTEM \"http://simgrid.gforge.inria.fr/simgrid.dtd\">\n"
+          "<platform version=\"3\">\n"
+          "<AS id=\"AS0\" routing=\"Full\">\n"
+          "  <cluster id=\"cloud\" prefix=\"vm-\" suffix=\"\" radical=\"0-%d\" power=\"%.17g\" bw=\"%.17g\" "
+          "lat=\"%.17g\" bb_bw=\"%.17g\" bb_lat=\"%.17g\"/>\n"
+          "</AS>\n"
+          "</platform>\n", n - 1, spec->speed, spec->bw, spec->lat, spec->bb_bw, spec->bb_lat);
+  fclose(f);
+
+  XBT_DEBUG("Pool of %d VMs described in %s", n, filename);
+  SD_create_environment(filename);
+  unlink(filename);
+}
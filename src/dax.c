@@ -6,15 +6,132 @@
  */
 
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
 #include "simgrid/simdag.h"
 #include "xbt.h"
 #include "scheduling.h"
 #include "dax.h"
 #include "task.h"
+#include "host.h"
+#include "rng.h"
+#include "engine.h"
 
 XBT_LOG_NEW_DEFAULT_SUBCATEGORY(dax, EnsembleSched, "Logging specific to daxes");
 
+/* Table of the descriptors of all the loaded DAXes. Tasks refer to the DAX they belong to by an index in this table
+ * rather than by a pointer, as the table grows when DAXes are registered.
+ */
+static struct _DaxDescriptor *descriptors = NULL;
+static int ndescriptors = 0;
+static int max_descriptors = 0;
+/* Number of DAXes whose tasks are still in memory, and its maximum over the run */
+static int nlive_daxes = 0;
+static int peak_live_daxes = 0;
+
+/* Create the descriptor of a DAX whose task attributes are already allocated, and link the tasks to it. The name is
+ * copied. Return the index of the descriptor.
+ */
+int register_dax(xbt_dynar_t dax, const char *name){
+  unsigned int i;
+  SD_task_t task;
+  DaxDescriptor descriptor;
+
+  if (ndescriptors == max_descriptors){
+    max_descriptors = max_descriptors ? 2 * max_descriptors : 64;
+    descriptors = (struct _DaxDescriptor *) realloc (descriptors, max_descriptors * sizeof(struct _DaxDescriptor));
+  }
+  descriptor = &(descriptors[ndescriptors]);
+  memset(descriptor, 0, sizeof(struct _DaxDescriptor));
+  descriptor->name = xbt_strdup(name);
+  descriptor->root = get_root(dax);
+  descriptor->end = get_end(dax);
+  descriptor->ntasks = xbt_dynar_length(dax);
+  descriptor->tasks = dax;
+
+  if (++nlive_daxes > peak_live_daxes)
+    peak_live_daxes = nlive_daxes;
+
+  xbt_dynar_foreach(dax, i, task){
+    ((TaskAttribute) SD_task_get_data(task))->dax_id = ndescriptors;
+    if (SD_task_get_kind(task) == SD_TASK_COMP_SEQ){
+      descriptor->ncompute_tasks++;
+      descriptor->remaining_work += SD_task_get_amount(task);
+    }
+  }
+
+  return ndescriptors++;
+}
+
+DaxDescriptor get_dax_descriptor(int id){
+  return &(descriptors[id]);
+}
+
+int get_number_of_daxes(){
+  return ndescriptors;
+}
+
+int get_peak_number_of_live_daxes(){
+  return peak_live_daxes;
+}
+
+/* A DAX is completed when its end task is done. This state is kept in the descriptor once the tasks are released. It
+ * is also set in the descriptor when a simulation stops while the end task is scheduled but not done yet (see
+ * dpds_settle_daxes).
+ */
+int dax_is_completed(int id){
+  DaxDescriptor descriptor = get_dax_descriptor(id);
+
+  if (descriptor->tasks && !descriptor->completed)
+    return (engine_task_get_state(descriptor->end) == SD_DONE);
+  return descriptor->completed;
+}
+
+/* Destroy all the tasks of a DAX, with their attributes and compute-only graph, and only keep its descriptor. Hosts
+ * that last executed one of these tasks forget about it, so that no resource dependency is added to a destroyed task.
+ */
+void release_dax(int id){
+  unsigned int i;
+  DaxDescriptor descriptor = get_dax_descriptor(id);
+  xbt_dynar_t dax = descriptor->tasks;
+  SD_task_t task;
+  sg_host_t host;
+
+  descriptor->completed = dax_is_completed(id);
+  xbt_dynar_foreach(dax, i, task){
+    if (SD_task_get_kind(task) == SD_TASK_COMP_SEQ && (host = engine_task_get_host(task))){
+      if (sg_host_get_last_scheduled_task(host) == task)
+        sg_host_set_last_scheduled_task(host, NULL);
+    }
+  }
+
+  free_compute_graph(dax);
+  SD_task_free_attributes(dax);
+  xbt_dynar_foreach(dax, i, task)
+    SD_task_destroy(task);
+  xbt_dynar_free_container(&dax);
+
+  descriptor->tasks = NULL;
+  descriptor->root = NULL;
+  descriptor->end = NULL;
+  nlive_daxes--;
+}
+
+/* Release the DAXes that are still in memory and all the descriptors */
+void free_dax_descriptors(){
+  int i;
+
+  for (i = 0; i < ndescriptors; i++){
+    if (descriptors[i].tasks)
+      release_dax(i);
+    free(descriptors[i].name);
+  }
+  free(descriptors);
+  descriptors = NULL;
+  ndescriptors = max_descriptors = 0;
+  nlive_daxes = peak_live_daxes = 0;
+}
+
 SD_task_t get_root(xbt_dynar_t dax){
   SD_task_t task;
 
@@ -29,6 +146,207 @@ SD_task_t get_end(xbt_dynar_t dax){
   return task;
 }
 
+/* Append a compute task to the children of the task at position stamp-1 in the DAX, unless it is already there, along
+ * with the size of the data it receives through this edge (-1 for a control dependency). While the graph is built, the
+ * pending_parents attribute of a task is used to store the stamp of the last task that added it to its children, and
+ * the unfinished_parents attribute the position of this edge, which allows for removing duplicates without searching.
+ * The size of a duplicate edge is the largest one, as transfers between two tasks happen at the same time.
+ */
+static void push_edge(int **edges, double **sizes, int *nedges, int *capacity, SD_task_t task, int stamp, double size){
+  TaskAttribute attr = (TaskAttribute) SD_task_get_data(task);
+
+  if (attr->pending_parents == stamp){
+    (*sizes)[attr->unfinished_parents] = MAX((*sizes)[attr->unfinished_parents], size);
+    return;
+  }
+  attr->pending_parents = stamp;
+  attr->unfinished_parents = *nedges;
+
+  if (*nedges == *capacity){
+    *capacity *= 2;
+    *edges = (int*) realloc (*edges, (*capacity)*sizeof(int));
+    *sizes = (double*) realloc (*sizes, (*capacity)*sizeof(double));
+  }
+  (*edges)[*nedges] = attr->dax_index;
+  (*sizes)[(*nedges)++] = size;
+}
+
+/* Build the compute-only dependency graph of a DAX, in which data transfers are folded in: a compute task is followed
+ * by a data transfer whose child (in a scheduling sense) is then the grand child. As more than one transfer may exist
+ * between two compute tasks, duplicates are removed, while the order of the children is kept.
+ * The children of the task at position i in the DAX are then given by children[offsets[i]] to
+ * children[offsets[i+1]-1], as positions in the DAX. See set_compute_graph for the way this graph is stored.
+ * Attributes have to be allocated (and their dax_index set) before calling this function.
+ */
+void build_compute_graph(xbt_dynar_t dax){
+  unsigned int i, j, k;
+  int nedges = 0, capacity = 64;
+  int *offsets, *edges;
+  double *sizes;
+  SD_task_t task, output, child;
+  xbt_dynar_t outputs, children;
+
+  offsets = (int*) calloc (xbt_dynar_length(dax) + 1, sizeof(int));
+  edges = (int*) calloc (capacity, sizeof(int));
+  sizes = (double*) calloc (capacity, sizeof(double));
+
+  xbt_dynar_foreach(dax, i, task)
+    ((TaskAttribute) SD_task_get_data(task))->pending_parents = 0;
+
+  xbt_dynar_foreach(dax, i, task){
+    offsets[i] = nedges;
+    if (SD_task_get_kind(task) != SD_TASK_COMP_SEQ)
+      continue;
+    outputs = SD_task_get_children(task);
+    xbt_dynar_foreach(outputs, j, output){
+      if (SD_task_get_kind(output) == SD_TASK_COMM_E2E) {
+        /* Data dependency case: the compute successors of the transfer are children of the task */
+        children = SD_task_get_children(output);
+        xbt_dynar_foreach(children, k, child){
+          if (SD_task_get_kind(child) == SD_TASK_COMP_SEQ)
+            push_edge(&edges, &sizes, &nedges, &capacity, child, i+1, SD_task_get_amount(output));
+        }
+        xbt_dynar_free_container(&children); /* avoid memory leaks */
+      } else if (SD_task_get_kind(output) == SD_TASK_COMP_SEQ) {
+        /* Control dependency case: a compute task successor is another compute task. */
+        push_edge(&edges, &sizes, &nedges, &capacity, output, i+1, -1.);
+      }
+    }
+    xbt_dynar_free_container(&outputs); /* avoid memory leaks */
+  }
+  offsets[xbt_dynar_length(dax)] = nedges;
+
+  set_compute_graph(dax, offsets, edges, sizes);
+
+  free(sizes);
+  free(edges);
+  free(offsets);
+}
+
+/* Compute the path_to_end attribute of the compute tasks of a DAX, and the critical and shortest paths of the DAX
+ * (see dax.h). A task is pushed in the ready queue upon the completion of one of its parents, and is done after its
+ * own amount of computation at best. The least amount of computation between the completion of a task and the
+ * scheduling of the end task is then the shortest path to a parent of the end task, where the length of a path is the
+ * amount of computation of its tasks. Tasks are handled in a reverse topological order, each one once all its
+ * children are.
+ */
+static void set_path_bounds(xbt_dynar_t dax){
+  unsigned int i;
+  int k, head = 0, tail = 0;
+  int *pending_children, *order;
+  double path, *longest;
+  SD_task_t task, parent, root = get_root(dax), end = get_end(dax);
+  SD_task_t *tasks = (SD_task_t*) xbt_dynar_get_ptr(dax, 0);
+  TaskAttribute attr, parent_attr;
+  DaxDescriptor descriptor = get_dax_descriptor(SD_task_get_dax_id(root));
+
+  pending_children = (int*) calloc (xbt_dynar_length(dax), sizeof(int));
+  order = (int*) calloc (xbt_dynar_length(dax), sizeof(int));
+  longest = (double*) calloc (xbt_dynar_length(dax), sizeof(double));
+
+  xbt_dynar_foreach(dax, i, task){
+    attr = (TaskAttribute) SD_task_get_data(task);
+    attr->path_to_end = 0.;
+    pending_children[i] = attr->nchildren;
+    if (!attr->nchildren && SD_task_get_kind(task) == SD_TASK_COMP_SEQ)
+      order[tail++] = i;
+  }
+
+  while (head < tail){
+    task = tasks[order[head]];
+    attr = (TaskAttribute) SD_task_get_data(task);
+    path = (task == end) ? 0. : SD_task_get_amount(task) + attr->path_to_end;
+    longest[order[head]] += SD_task_get_amount(task);
+    for (k = 0; k < attr->nparents; k++){
+      parent = attr->parents[k];
+      parent_attr = (TaskAttribute) SD_task_get_data(parent);
+      if (pending_children[parent_attr->dax_index] == parent_attr->nchildren || path < parent_attr->path_to_end)
+        parent_attr->path_to_end = path;
+      longest[parent_attr->dax_index] = MAX(longest[parent_attr->dax_index], longest[order[head]]);
+      if (--pending_children[parent_attr->dax_index] == 0)
+        order[tail++] = parent_attr->dax_index;
+    }
+    head++;
+  }
+
+  descriptor->critical_path = longest[((TaskAttribute) SD_task_get_data(root))->dax_index];
+  descriptor->shortest_path = SD_task_get_amount(root) + ((TaskAttribute) SD_task_get_data(root))->path_to_end;
+
+  free(longest);
+  free(order);
+  free(pending_children);
+}
+
+/* Store the compute-only dependency graph of a DAX in a compact way (CSR): the children and parents of each compute
+ * task are slices of a single array allocated for the whole DAX and owned by its descriptor. The children slices come
+ * first, in the order of the tasks in the DAX. The sizes of the data sent through the edges, given in the order of the
+ * children, are stored the same way, both in the order of the children and of the parents. If no sizes are given, all
+ * the edges are control dependencies (size of -1). The number of compute parents that are not scheduled yet and the
+ * path to the end task are also initialized for each compute task, as well as the path bounds of the DAX. The DAX has
+ * to be registered before calling this function.
+ */
+void set_compute_graph(xbt_dynar_t dax, const int *offsets, const int *children, const double *sizes){
+  unsigned int i, k;
+  int first, nedges = offsets[xbt_dynar_length(dax)];
+  SD_task_t *base, *tasks;
+  double *base_sizes;
+  SD_task_t task;
+  TaskAttribute attr;
+  DaxDescriptor descriptor;
+
+  tasks = (SD_task_t*) xbt_dynar_get_ptr(dax, 0);
+  base = (SD_task_t*) calloc (2*nedges + 1, sizeof(SD_task_t));
+  base_sizes = (double*) calloc (2*nedges + 1, sizeof(double));
+  descriptor = get_dax_descriptor(SD_task_get_dax_id(tasks[0]));
+  descriptor->compute_graph = base;
+  descriptor->edge_sizes = base_sizes;
+
+  /* Set the children slices and count the parents of each compute task */
+  xbt_dynar_foreach(dax, i, task){
+    attr = (TaskAttribute) SD_task_get_data(task);
+    attr->children = base + offsets[i];
+    attr->output_sizes = base_sizes + offsets[i];
+    attr->nchildren = offsets[i+1] - offsets[i];
+    attr->nparents = 0;
+  }
+  for (k = 0; k < nedges; k++){
+    base[k] = tasks[children[k]];
+    base_sizes[k] = sizes ? sizes[k] : -1.;
+    ((TaskAttribute) SD_task_get_data(base[k]))->nparents++;
+  }
+
+  /* Set the parents slices, located after the children ones, and fill them */
+  first = nedges;
+  xbt_dynar_foreach(dax, i, task){
+    attr = (TaskAttribute) SD_task_get_data(task);
+    attr->parents = base + first;
+    attr->input_sizes = base_sizes + first;
+    first += attr->nparents;
+    attr->pending_parents = 0;
+    attr->unfinished_parents = attr->nparents;
+  }
+  xbt_dynar_foreach(dax, i, task){
+    attr = (TaskAttribute) SD_task_get_data(task);
+    for (k = 0; k < attr->nchildren; k++){
+      TaskAttribute child_attr = (TaskAttribute) SD_task_get_data(attr->children[k]);
+      child_attr->input_sizes[child_attr->pending_parents] = attr->output_sizes[k];
+      child_attr->parents[child_attr->pending_parents++] = task;
+    }
+  }
+
+  set_path_bounds(dax);
+}
+
+/* Release the compute-only dependency graph of a DAX */
+void free_compute_graph(xbt_dynar_t dax){
+  DaxDescriptor descriptor = get_dax_descriptor(SD_task_get_dax_id(get_root(dax)));
+
+  free(descriptor->compute_graph);
+  free(descriptor->edge_sizes);
+  descriptor->compute_graph = NULL;
+  descriptor->edge_sizes = NULL;
+}
+
 /* Comparison function to sort DAXes increasingly according to their size.
  * Assumption: this size consider all tasks (computations AND transfers). Could be modified to count only compute tasks.
  */
@@ -47,13 +365,12 @@ int sizeCompareDaxes(const void *d1, const void *d2) {
 }
 
 /* Implementation of Knuth shuffle found on the web.
- * Arrange the N elements of ARRAY in random order. Only effective if N is much smaller than RAND_MAX; if this may not
- * be the case, use a better random number generator. */
+ * Arrange the N elements of ARRAY in random order, drawn from the stream of random numbers dedicated to priorities. */
 void shuffle(int *array, size_t n){
   if (n > 1){
     size_t i;
     for (i = 0; i < n - 1; i++){
-      size_t j = i + rand() / (RAND_MAX / (n - i) + 1);
+      size_t j = i + rng_uniform_int(RNG_PRIORITIES, n - i);
       int t = array[j];
       array[j] = array[i];
       array[i] = t;
@@ -72,10 +389,9 @@ void shuffle(int *array, size_t n){
  */
 void assign_dax_priorities(xbt_dynar_t daxes, method_t method){
   int *priorities;
-  unsigned int i, j;
+  unsigned int i;
   int ndaxes = xbt_dynar_length(daxes);
   xbt_dynar_t current_dax;
-  SD_task_t task;
 
   priorities = (int*) calloc (ndaxes, sizeof(int));
   for (i=0;i<ndaxes;i++)
@@ -88,26 +404,22 @@ void assign_dax_priorities(xbt_dynar_t daxes, method_t method){
   }
 
   xbt_dynar_foreach(daxes, i, current_dax){
-    xbt_dynar_foreach(current_dax,j, task){
-      SD_task_set_dax_priority(task, priorities[i]);
-    }
+    get_dax_descriptor(SD_task_get_dax_id(get_root(current_dax)))->priority = priorities[i];
   }
   free(priorities);
 }
 
-double compute_score(xbt_dynar_t daxes){
+/* Score of the schedule of all the DAXes, including those that have been released */
+double compute_score(){
   double total_score = 0;
   double current_score;
-  unsigned int i;
-  xbt_dynar_t current_dax;
-  SD_task_t task;
+  int i;
 
-  xbt_dynar_foreach(daxes, i, current_dax){
-    task = get_end(current_dax);
-    if (SD_task_get_state(task) == SD_DONE){
-      current_score = pow(2.0, -SD_task_get_dax_priority(task));
+  for (i = 0; i < get_number_of_daxes(); i++){
+    if (dax_is_completed(i)){
+      current_score = pow(2.0, -get_dax_descriptor(i)->priority);
       XBT_DEBUG("%s has completed its execution. It contributes to the score by %f",
-                SD_task_get_dax_name(task), current_score);
+                get_dax_descriptor(i)->name, current_score);
       total_score += current_score;
     }
   }
@@ -6,18 +6,26 @@
  *
  * dpds.c
  * SimDAG implementation of the Dynamic Provisioning, Dynamic Scheduling
- * Algorithm from
+ * Algorithm and of its Workflow-Aware variant (WA-DPDS) from
  * Cost- and Deadline-Constrained Provisioning for Scientific Workflow
  * Ensembles in IaaS Clouds by Maciej Malawski, Gideon Juve, Ewa Deelman and
  * Jarek Nabrzyski published at SC'12.
  */
 #include <stdio.h>
 #include <math.h>
+#include <float.h>
 #include "xbt.h"
 #include "simgrid/simdag.h"
 #include "dax.h"
 #include "host.h"
+#include "billing.h"
 #include "task.h"
+#include "queue.h"
+#include "trace.h"
+#include "stats.h"
+#include "arrival.h"
+#include "explore.h"
+#include "engine.h"
 #include "scheduling.h"
 
 XBT_LOG_NEW_DEFAULT_SUBCATEGORY(dpds, EnsembleSched, "Logging specific to the DPDS algorithm");
@@ -37,7 +45,7 @@ XBT_LOG_NEW_DEFAULT_SUBCATEGORY(dpds, EnsembleSched, "Logging specific to the DP
 void dpds_provision(double c, double t, scheduling_globals_t globals){
   unsigned int i;
   double u;
-  xbt_dynar_t VR = get_running_VMs();
+  int nVR = get_number_of_running_VMs();
   xbt_dynar_t VC = get_ending_billing_cycle_VMs(globals->period, 1.);
   xbt_dynar_t VT = NULL; /* set of VMs to terminate */
   xbt_dynar_t VI = NULL;
@@ -45,7 +53,7 @@ void dpds_provision(double c, double t, scheduling_globals_t globals){
   int nT = 0;
 
   if (((globals->budget-c) < (xbt_dynar_length(VC)*globals->price)) || (t > globals->deadline)){
-    nT = xbt_dynar_length(VR) - floor((globals->budget-c)/globals->price);
+    nT = nVR - floor((globals->budget-c)/globals->price);
 
     XBT_VERB("$%f remain and %zu VMs are close to their billing cycle. Have to stop %d VMs",
              globals->budget-c, xbt_dynar_length(VC), nT);
@@ -59,13 +67,14 @@ void dpds_provision(double c, double t, scheduling_globals_t globals){
   } else {
     u = compute_current_VM_utilization();
 
-    if ((u > globals->uh) && (xbt_dynar_length(VR) < (globals->vmax*globals->nVM))){
+    if ((u > globals->uh) && (nVR < (globals->vmax*globals->nVM))){
       /* WARNING: a VM can be start while the budget is already spent! An extra test should be added */
-      XBT_VERB("%.2f is above upper threshold and some VMs have been stopped before (%zu < %f). Start a new VM ...",
-          u, xbt_dynar_length(VR), (globals->vmax*globals->nVM));
+      XBT_VERB("%.2f is above upper threshold and some VMs have been stopped before (%d < %f). Start a new VM ...",
+          u, nVR, (globals->vmax*globals->nVM));
 
       v = find_inactive_VM_to_start();
-      sg_host_start(v);
+      if (v)
+        sg_host_start(v);
     } else if (u < globals->ul) {
       VI = get_idle_VMs();
       nT = ceil(xbt_dynar_length(VI)/2.);
@@ -79,43 +88,270 @@ void dpds_provision(double c, double t, scheduling_globals_t globals){
       xbt_dynar_free_container(&VT);
     }
   }
-  xbt_dynar_free_container(&VR);
   xbt_dynar_free_container(&VC);
 }
 
+/* Fast-forward mode: determine the first provisioning period at which dpds_provision may act, assuming that no task
+ * completes in the meantime (a completion wakes up the scheduler anyway and the decision is then made again). The
+ * provisioning calls at the periods in between would do nothing:
+ *  - The utilization and the number of running VMs only change upon task completions or provisioning actions. If the
+ *    utilization does not trigger the start or the termination of VMs now, it will not do so before the next event.
+ *  - VMs are terminated because of the budget only if the remaining budget cannot pay for one more hour of the VMs
+ *    that approach the end of their billing cycle. If it can pay for one more hour of all the running VMs, this
+ *    cannot happen before the consumed budget changes, i.e., before a VM reaches a billing boundary. Otherwise, this
+ *    cannot happen before a VM approaches such a boundary.
+ *  - The deadline stops the main loop, and the branching points of a what-if exploration must not be skipped.
+ * The schedule is then the same as when the scheduler wakes up at every period. Only the utilization samples of the
+ * trace (trace_period) are not written for the skipped periods.
+ */
+static int dpds_fast_forward(int step, scheduling_globals_t globals){
+  double u, horizon;
+  int nVR;
+
+  if (!globals->fast_forward)
+    return step;
+
+  /* Periods may have been skipped before a task completion woke the scheduler up. The next period to consider is the
+   * one that ends now or next.
+   */
+  step = MAX(step, (int) ceil((engine_get_clock() - 0.00001) / globals->period));
+
+  u = compute_current_VM_utilization();
+  nVR = get_number_of_running_VMs();
+  if ((u > globals->uh && nVR < globals->vmax * globals->nVM) || (u < globals->ul && get_number_of_idle_VMs()))
+    return step;
+
+  if (globals->budget - get_committed_budget() > 0.00001)
+    horizon = get_next_billing_boundary(0.);
+  else
+    horizon = get_next_billing_boundary(globals->period + 1.);
+  horizon = MIN(MIN(horizon, globals->deadline), explore_next_branch_time());
+
+  if (horizon / globals->period > step){
+    XBT_DEBUG("Fast-forward to %.3f", horizon);
+    return (int) ceil(horizon / globals->period);
+  }
+  return step;
+}
+
+/* Amount of computation left in the running DAXes (in flops), i.e., those admitted by WA-DPDS that are not completed
+ * yet. Maintained upon each task completion.
+ */
+static double running_work = 0.;
+
+/* Admission control of WA-DPDS. A DAX is admitted when its root task is about to be scheduled, if the estimated cost
+ * of finishing it along with all the running DAXes does not exceed the budget that is not committed yet, i.e., minus
+ * the hours already charged and the hours the running VMs will be charged at their next billing boundary.
+ * Remark: The cost is estimated from the remaining amount of computation, as if it was executed on VMs that are never
+ * idle.
+ */
+static int wadpds_admit(DaxDescriptor dax, double speed, scheduling_globals_t globals){
+  double cost = (running_work + dax->remaining_work) / speed / 3600. * globals->price;
+  double remaining_budget = globals->budget - get_committed_budget();
+
+  if (cost > remaining_budget){
+    XBT_INFO("%s: Rejected (estimated cost of $%.2f for $%.2f uncommitted)", dax->name, cost, remaining_budget);
+    return 0;
+  }
+  XBT_VERB("%s: Admitted (estimated cost of $%.2f for $%.2f uncommitted)", dax->name, cost, remaining_budget);
+  dax->admitted = 1;
+  running_work += dax->remaining_work;
+  return 1;
+}
+
+/* Account for the completion of a compute task in the estimates of the remaining work. A completed DAX is no longer
+ * running, whatever rounding errors are left in its remaining work.
+ */
+static void update_remaining_work(DaxDescriptor dax, SD_task_t t){
+  dax->remaining_work -= SD_task_get_amount(t);
+  if (!dax->admitted)
+    return;
+  running_work -= SD_task_get_amount(t);
+  if (t == dax->end){
+    running_work -= dax->remaining_work;
+    dax->remaining_work = 0.;
+  }
+}
+
+/* Least amount of computation (in flops) left before the end task of each DAX can be scheduled (early abort) */
+static double *bounds = NULL;
+static int max_bounds = 0;
+
+/* Early abort: a DAX counts in the score if and only if its end task is scheduled before the deadline. All the
+ * ancestors of this task are then scheduled too, and finish when the remaining tasks are drained. The end task of the
+ * other DAXes cannot be scheduled before the current time plus the least amount of computation that lies between
+ * their tasks that are queued or scheduled and their end task (see set_path_bounds in dax.c). A DAX for which this
+ * lower bound exceeds the deadline is doomed and no longer considered. Once all the DAXes that are not done yet are
+ * either doomed or bound to complete, and no more DAX arrives before the deadline, the score cannot change anymore:
+ * the DAXes bound to complete are set as completed and the simulation can stop. Return 1 in that case.
+ * Remark: Doomed DAXes are still scheduled as usual, for the schedule of the other DAXes to be the same.
+ */
+static int dpds_settle_daxes(ready_queue_t queue, double speed, scheduling_globals_t globals){
+  unsigned int i;
+  int j, id, settled = 1;
+  double now = engine_get_clock();
+  xbt_dynar_t busy_VMs;
+  DaxDescriptor dax;
+  SD_task_t t;
+  sg_host_t v;
+
+  if (!globals->early_abort || (globals->deadline - get_next_arrival_time()) > 0.00001)
+    return 0;
+
+  if (max_bounds < get_number_of_daxes()){
+    max_bounds = 2 * get_number_of_daxes();
+    bounds = (double*) realloc (bounds, max_bounds * sizeof(double));
+  }
+  for (id = 0; id < get_number_of_daxes(); id++)
+    bounds[id] = DBL_MAX;
+
+  /* A queued task may be scheduled now, a scheduled one may complete now */
+  for (j = 0; j < ready_queue_length(queue); j++){
+    t = ready_queue_get(queue, j);
+    id = SD_task_get_dax_id(t);
+    if (t == get_dax_descriptor(id)->end)
+      bounds[id] = 0.;
+    else
+      bounds[id] = MIN(bounds[id], SD_task_get_amount(t) + SD_task_get_path_to_end(t));
+  }
+  busy_VMs = get_busy_VMs();
+  xbt_dynar_foreach(busy_VMs, i, v){
+    t = sg_host_get_last_scheduled_task(v);
+    if (t && SD_task_get_kind(t) == SD_TASK_COMP_SEQ && engine_task_get_state(t) != SD_DONE){
+      id = SD_task_get_dax_id(t);
+      bounds[id] = MIN(bounds[id], SD_task_get_path_to_end(t));
+    }
+  }
+  xbt_dynar_free_container(&busy_VMs);
+
+  for (id = 0; id < get_number_of_daxes(); id++){
+    dax = get_dax_descriptor(id);
+    if (!dax->tasks || dax->end_scheduled || dax->doomed)
+      continue;
+    if ((globals->deadline - now) < 0.00001 || (now + bounds[id] / speed - globals->deadline) > 0.00001){
+      XBT_VERB("%s: Cannot complete before the deadline", dax->name);
+      dax->doomed = 1;
+    } else {
+      settled = 0;
+    }
+  }
+  if (!settled)
+    return 0;
+
+  for (id = 0; id < get_number_of_daxes(); id++){
+    dax = get_dax_descriptor(id);
+    if (dax->tasks && dax->end_scheduled && !dax_is_completed(id)){
+      XBT_INFO("%s: Complete! (end task scheduled at %.3f)", dax->name, now);
+      dax->completed = 1;
+    }
+  }
+  return 1;
+}
+
+/* Let the simulation run, accounting for the time spent in the simulation engine */
+static xbt_dynar_t dpds_simulate(double how_long){
+  xbt_dynar_t changed;
+
+  STATS_START(STATS_SIMULATE);
+  changed = engine_simulate(how_long);
+  STATS_STOP(STATS_SIMULATE);
+  count_wakeup();
+
+  return changed;
+}
+
+/* Action on completion of tasks (lines 13 to 15): the VMs that executed them become idle and their children that are
+ * ready are inserted in the priority queue. The tasks of the DAXes that complete are released once all the completions
+ * are handled, as other tasks of the same DAXes may appear in the list. Return the number of completed DAXes.
+ */
+static int dpds_handle_completions(xbt_dynar_t changed, ready_queue_t queue, xbt_dynar_t released){
+  unsigned int i, j;
+  int completed_daxes = 0, id;
+  SD_task_t *children = NULL;
+  DaxDescriptor dax;
+  SD_task_t t;
+  sg_host_t v;
+
+  STATS_START(STATS_COMPLETION);
+  STATS_RECORD(STATS_TASKS_PER_WAKEUP, changed ? xbt_dynar_length(changed) : 0);
+  xbt_dynar_foreach(changed, i, t){
+    /* If VM have a provisioning delay, a task whose name starts by "Booting" has been created. No action taken
+     * upon completion of such a task apart from displaying some verbose output.
+     */
+    if (!strncmp(SD_task_get_name(t), "Booting", 7)){
+      XBT_VERB("%s is done", SD_task_get_name(t));
+      continue;
+    }
+
+    if (SD_task_get_kind(t) == SD_TASK_COMP_SEQ && engine_task_get_state(t) == SD_DONE){
+      XBT_VERB("%s (from %s) has completed", SD_task_get_name(t), SD_task_get_dax_name(t));
+      trace_task(t);
+
+      /* get the host used to compute this task */
+      v = engine_task_get_host(t);
+
+      /* Set it to idle, which adds it to the set of idle VMs */
+      sg_host_set_to_idle(v);
+
+      /* Detection of the completion of a workflow */
+      dax = get_dax_descriptor(SD_task_get_dax_id(t));
+      dax->ncompleted_tasks++;
+      update_remaining_work(dax, t);
+      if (t == dax->end){
+        XBT_INFO("%s: Complete!", dax->name);
+        dax->completed = 1;
+        completed_daxes++;
+        id = SD_task_get_dax_id(t);
+        xbt_dynar_push(released, &id);
+      }
+      /* add ready children of t to the priority queue. A task that is already queued is ignored by the queue
+       * itself. May occur as soon as a task as more than one parent. */
+      children = SD_task_get_compute_children(t);
+      for (j = 0; j < SD_task_get_compute_children_count(t); j++){
+        if (SD_task_is_ready(children[j]))
+          ready_queue_push(queue, children[j]);
+      }
+    }
+  }
+
+  xbt_dynar_foreach(released, i, id)
+    release_dax(id);
+  xbt_dynar_reset(released);
+  STATS_STOP(STATS_COMPLETION);
+
+  return completed_daxes;
+}
 
 /* (adapted) Implementation of Algorithm 2 on page 3 of the paper by Malawski et al. Use the global scheduling data
  * structure for convenience.
  */
 void dpds_schedule(xbt_dynar_t daxes, scheduling_globals_t globals){
   unsigned int i, j;
-  int first_call = 1, step = 1;
-  int completed_daxes = 0;
-  double consumed_budget;
-  xbt_dynar_t priority_queue;
-  xbt_dynar_t idleVMs = NULL;
-  xbt_dynar_t ready_children = NULL;
+  int first_call = 1, step = 1, next_step = 1, explored = 0, settled = 0, pending;
+  int completed_daxes = 0, rejected_daxes = 0;
+  /* DAXes that are already there and those that will arrive later (online mode) */
+  int ndaxes = xbt_dynar_length(daxes) + get_number_of_pending_arrivals();
+  double consumed_budget, period, speed = sg_host_speed(sg_host_list()[0]);
+  ready_queue_t priority_queue;
   xbt_dynar_t current_dax = NULL, changed = NULL;
-  SD_task_t root, t, child;
+  xbt_dynar_t released = xbt_dynar_new(sizeof(int), NULL);
+  SD_task_t root, t;
+  DaxDescriptor dax;
   sg_host_t v;
 
   /* Initialization step: lines 2 to 6 */
-  priority_queue = xbt_dynar_new(sizeof (SD_task_t), NULL);
-  idleVMs = get_idle_VMs();
+  priority_queue = ready_queue_new(xbt_dynar_length(daxes));
 
+  /* The priority queue is a heap ordered by decreasing value of DAX priority. ready_queue_pop then returns the most
+   * important task.
+   * Remark: The paper by Malawski et al. does not detail the INSERT function(Algorithm 2, line 5). Tasks that belong
+   * to the same DAX are popped in their insertion order to keep the schedule deterministic.
+   */
   xbt_dynar_foreach(daxes, i, current_dax){
     root = get_root(current_dax);
-    xbt_dynar_push(priority_queue, &root);
+    ready_queue_push(priority_queue, root);
   }
 
-  /* Sort the priority queue by increasing value of DAX priority.
-   * Tasks that belong to the most important DAX are located toward the end ofthe dynar. xbt_dynar_pop then return the
-   * most important task.
-   * Remark: The paper by Malawski et al. does not detail the INSERT function(Algorithm 2, line 5). Then no secondary
-   * sort is applied for tasks that belong to the same DAX.
-   */
-  xbt_dynar_sort(priority_queue, daxPriorityCompareTasks);
-
   do{
     /* Main scheduling loop: lines 7 to 16 */
     /* Remark: order is changed w.r.t to the article (lines 13-15 then lines 8-12) but not the behavior as there is a
@@ -125,129 +361,179 @@ void dpds_schedule(xbt_dynar_t daxes, scheduling_globals_t globals){
     /* This do-while external loop is to ensure that we call the main scheduling loop again even though no event
      * occurred during a complete provisioning period.
      */
-    while (first_call || ((completed_daxes < xbt_dynar_length(daxes)) &&
-            ((step*globals->period - SD_get_clock())<0.00001 ||
-            !xbt_dynar_is_empty((changed = SD_simulate(MIN(step*globals->period,globals->deadline) - SD_get_clock())))
+    while (first_call || ((completed_daxes + rejected_daxes < ndaxes) &&
+            ((next_step*globals->period - engine_get_clock())<0.00001 ||
+            (get_next_arrival_time() - engine_get_clock())<0.00001 ||
+            !xbt_dynar_is_empty((changed = dpds_simulate(MIN(MIN(next_step*globals->period,globals->deadline),
+                                                             get_next_arrival_time()) - engine_get_clock())))
             ))){
       /* Apart of the first specific call, the simulation is suspended when
        *  - All the DAXes are done (no more work to be done, why continue?)
        *  - a watch point is reached, meaning a compute task has finished
        *  - a provisioning period has ended
+       *  - a new workflow arrives (online mode)
        *  - the deadline is met
        */
       /* Handling specific stopping conditions */
       first_call=0;
-      if (((step*globals->period)-SD_get_clock())<0.00001){
-        XBT_DEBUG("End of a period of %.0f seconds. Start a new one", globals->period);
-        step++;
-
-        /* Compute current budget consumption */
-        consumed_budget = compute_budget_consumption();
-        XBT_VERB("$%f have already been spent", consumed_budget);
-
-        /* Call dpds_provision*/
-        XBT_DEBUG("Dynamic Provisioning at time %f", SD_get_clock());
-        dpds_provision(consumed_budget, SD_get_clock(), globals);
-        /* It may have change the set of idle VMs, recompute it */
-        xbt_dynar_free_container(&idleVMs); /*avoid memory leaks */
-        idleVMs = get_idle_VMs();
-        continue;
+      if (((next_step*globals->period)-engine_get_clock())<0.00001){
+        /* Tasks may complete exactly at the end of the period. Their completion is handled first, for the early abort
+         * and the provisioning decision to account for it, and the tasks they make ready are scheduled right after.
+         */
+        pending = !xbt_dynar_is_empty(changed);
+        if (pending)
+          completed_daxes += dpds_handle_completions(changed, priority_queue, released);
+        changed = NULL;
+
+        /* What-if exploration: branches may be forked here, before the provisioning decision. Once they are all done,
+         * the simulation of the parent process stops. A branch that changes the period skips to the first multiple of
+         * the new period.
+         */
+        period = globals->period;
+        if (explore_branch_point(globals)){
+          explored = 1;
+          break;
+        }
+        if (globals->period != period)
+          step = next_step = (int) ceil((engine_get_clock() - 0.00001) / globals->period);
+
+        if ((next_step*globals->period - engine_get_clock()) < 0.00001){
+          XBT_DEBUG("End of a period of %.0f seconds. Start a new one", globals->period);
+          step = next_step + 1;
+
+          /* Get current budget consumption from the ledger */
+          consumed_budget = get_consumed_budget();
+          XBT_VERB("$%f have already been spent", consumed_budget);
+          trace_period(compute_current_VM_utilization(), consumed_budget);
+
+          /* Early abort: stop as soon as the score cannot change anymore */
+          if (dpds_settle_daxes(priority_queue, speed, globals)){
+            XBT_INFO("No more DAX can complete before the deadline. Stop at %.3f", engine_get_clock());
+            report_early_abort();
+            settled = 1;
+            break;
+          }
+
+          /* Call dpds_provision*/
+          XBT_DEBUG("Dynamic Provisioning at time %f", engine_get_clock());
+          STATS_START(STATS_PROVISIONING);
+          dpds_provision(consumed_budget, engine_get_clock(), globals);
+          STATS_STOP(STATS_PROVISIONING);
+          next_step = dpds_fast_forward(step, globals);
+        }
+        if (!pending)
+          continue;
       }
-      if (globals->deadline <= SD_get_clock()){
-        XBT_INFO("Time's up! Deadline was reached at %.3f", SD_get_clock());
+      if (globals->deadline <= engine_get_clock()){
+        XBT_INFO("Time's up! Deadline was reached at %.3f", engine_get_clock());
         break;
       }
 
+      /* Online mode: DAXes are loaded when they arrive and their root is inserted in the priority queue */
+      while ((get_next_arrival_time() - engine_get_clock())<0.00001){
+        current_dax = load_next_arrival();
+        ready_queue_push(priority_queue, get_root(current_dax));
+      }
+
       /* Typical loop body*/
       /* Action on completion of a task (lines 13 to 15) */
+      completed_daxes += dpds_handle_completions(changed, priority_queue, released);
+      /* These completions are handled, the same list must not be handled again if the next wake-up is an arrival */
+      changed = NULL;
 
-      xbt_dynar_foreach(changed, i, t){
-        /* If VM have a provisioning delay, a task whose name starts by "Booting" has been created. No action taken
-         * upon completion of such a task apart from displaying some verbose output.
-         */
-        if (!strncmp(SD_task_get_name(t), "Booting", 7)){
-          XBT_VERB("%s is done", SD_task_get_name(t));
-          continue;
-        }
-
-        if (SD_task_get_kind(t) == SD_TASK_COMP_SEQ && SD_task_get_state(t) == SD_DONE){
-          XBT_VERB("%s (from %s) has completed", SD_task_get_name(t), SD_task_get_dax_name(t));
+      /* Display the current contents of the priority queue as debug information*/
+      for (j = 0; j < ready_queue_length(priority_queue); j++)
+        XBT_DEBUG("%s is in priority queue", SD_task_get_name(ready_queue_get(priority_queue, j)));
 
-          /* get the host used to compute this task */
-          v = (SD_task_get_workstation_list(t))[0];
+      /* Task scheduling part (lines 8 to 12) */
+      STATS_START(STATS_SCHEDULING);
+      STATS_RECORD(STATS_QUEUE_LENGTH, ready_queue_length(priority_queue));
+      STATS_RECORD(STATS_IDLE_VMS, get_number_of_idle_VMs());
+      while (get_number_of_idle_VMs() && (!ready_queue_is_empty(priority_queue))){
 
-          /* Set it to idle and add it the list of idle VMs */
-          sg_host_set_to_idle(v);
-          xbt_dynar_push(idleVMs, &v);
+        /* Pop the first task from the queue, i.e. one belonging to the DAX of highest priority. */
+        t = ready_queue_pop(priority_queue);
 
-          /* Detection of the completion of a workflow */
-          if (!strcmp(SD_task_get_name(t), "end")){
-            XBT_INFO("%s: Complete!", SD_task_get_dax_name(t));
-            completed_daxes++;
-          }
-          /* add ready children of t to the priority queue */
-          ready_children = SD_task_get_ready_children(t);
-          xbt_dynar_foreach(ready_children, j, child){
-            /* Ensure that a task is not added more than once to the queue. May occur as soon as a task as more than
-             * one parent. */
-            if (!xbt_dynar_member(priority_queue, &child))
-              xbt_dynar_push(priority_queue, &child);
-          }
-          xbt_dynar_free_container(&ready_children); /* avoid memory leaks */
+        /* WA-DPDS: the root task of a DAX is only scheduled if the DAX passes the admission control. The tasks of a
+         * rejected DAX are never scheduled and can be released right away.
+         */
+        dax = get_dax_descriptor(SD_task_get_dax_id(t));
+        if (globals->alg == WADPDS && t == dax->root && !wadpds_admit(dax, speed, globals)){
+          rejected_daxes++;
+          release_dax(SD_task_get_dax_id(t));
+          continue;
         }
-      }
-
-      /* Sort again the priority queue as new tasks have been added. */
-      xbt_dynar_sort(priority_queue, daxPriorityCompareTasks);
-      /* Display the current contents of the priority queue as debug information*/
-      xbt_dynar_foreach(priority_queue,j,child)
-        XBT_DEBUG("%s is in priority queue", SD_task_get_name(child));
 
-      /* Task scheduling part (lines 8 to 12) */
-      while ((!xbt_dynar_is_empty(idleVMs)) && (!xbt_dynar_is_empty(priority_queue))){
-
-        /* Remove a random VM from the list of idleVMs and set it as busy */
-        v = select_random(idleVMs);
+        /* Select a random VM among the idle ones and set it as busy, which removes it from the set of idle VMs. With
+         * data locality, a VM that executed a parent of the task is preferred.
+         */
+        v = globals->locality ? select_local_idle_VM(t) : NULL;
+        if (!v)
+          v = select_random_idle_VM();
         sg_host_set_to_busy(v);
 
-        /* Pop the last task from the queue, i.e. one belonging to the DAX of highest priority. */
-        xbt_dynar_pop(priority_queue, &t);
-
         XBT_VERB("Schedule %s (%s) on %s", SD_task_get_name(t), SD_task_get_dax_name(t), sg_host_get_name(v));
-
-        SD_task_schedulel(t, 1, v);
-        handle_resource_dependency(v, t);
+        /* The native engine already ignores transfers within a VM */
+        if (globals->locality && engine_get_type() == ENGINE_SIMGRID)
+          handle_local_transfers(v, t, engine_task_get_host);
+
+        engine_schedule(t, v);
+        if (t == dax->end)
+          dax->end_scheduled = 1;
+        SD_task_release_children(t);
       }
+      STATS_STOP(STATS_SCHEDULING);
+      next_step = dpds_fast_forward(step, globals);
     }
-  } while ((globals->deadline - SD_get_clock() > 0.00001) && (completed_daxes < xbt_dynar_length(daxes)));
+  } while (!explored && !settled && (globals->deadline - engine_get_clock() > 0.00001) &&
+           (completed_daxes + rejected_daxes < ndaxes));
 
-  /* We may have reached the deadline while some tasks are still running. Let's call SD_simulate one last time to let
-   * them finish.
+  /* We may have reached the deadline while some tasks are still running. Let the simulation run one last time to let
+   * them finish, unless the DAXes that complete in the meantime can be determined without simulating them (early
+   * abort).
    */
-  if (globals->deadline - SD_get_clock() < 0.00001){
-    XBT_INFO("Deadline was reached!");
-    changed = SD_simulate(-1);
-    xbt_dynar_foreach(changed, i, t){
-      if (SD_task_get_kind(t) == SD_TASK_COMP_SEQ && SD_task_get_state(t) == SD_DONE){
-        XBT_VERB("%s (from %s) has completed after the deadline", SD_task_get_name(t), SD_task_get_dax_name(t));
+  if (!explored && !settled && globals->deadline - engine_get_clock() < 0.00001){
+    if (dpds_settle_daxes(priority_queue, speed, globals)){
+      report_early_abort();
+    } else {
+      XBT_INFO("Deadline was reached!");
+      changed = dpds_simulate(-1);
+      xbt_dynar_foreach(changed, i, t){
+        if (SD_task_get_kind(t) == SD_TASK_COMP_SEQ && engine_task_get_state(t) == SD_DONE){
+          XBT_VERB("%s (from %s) has completed after the deadline", SD_task_get_name(t), SD_task_get_dax_name(t));
+          trace_task(t);
+          dax = get_dax_descriptor(SD_task_get_dax_id(t));
+          dax->ncompleted_tasks++;
+          update_remaining_work(dax, t);
+          if (t == dax->end)
+            dax->completed = 1;
+        }
       }
     }
   }
 
   /* Cleaning step once simulation is over */
-  xbt_dynar_free_container(&idleVMs);
-  xbt_dynar_free_container(&priority_queue);
+  running_work = 0.;
+  free(bounds);
+  bounds = NULL;
+  max_bounds = 0;
+  ready_queue_free(&priority_queue);
+  xbt_dynar_free(&released);
+}
+
+/* Number of VMs started at the beginning of the simulation by DPDS and WA-DPDS.
+ * Deadline is expressed in seconds, while price is for an hour. Conversion is needed.
+ */
+int dpds_initial_VMs(scheduling_globals_t globals){
+  return ceil(globals->budget / (MAX(1, (globals->deadline / 3600.)) * globals->price));
 }
 
 void dpds(xbt_dynar_t daxes, scheduling_globals_t globals){
   int i;
   const sg_host_t *hosts = sg_host_list();
 
-  /* Start by activating nVM VMs
-   * Deadline is expressed in seconds, while price is for an hour.
-   * Conversion is needed.
-   */
-  globals->nVM = ceil(globals->budget / (MAX(1, (globals->deadline / 3600.)) * globals->price));
+  /* Start by activating nVM VMs */
+  globals->nVM = dpds_initial_VMs(globals);
   XBT_VERB("%d VMs are initially started", globals->nVM);
   for (i = 0; i < globals->nVM; i++){
     sg_host_start(hosts[i]);
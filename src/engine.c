@@ -0,0 +1,261 @@
+/*
+ * Copyright (c) Centre de Calcul de l'IN2P3 du CNRS
+ * Contributor(s) : Frédéric SUTER (2012-2016)
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the license (GNU LGPL) which comes with this package.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <float.h>
+#include "xbt.h"
+#include "simgrid/simdag.h"
+#include "task.h"
+#include "host.h"
+#include "scheduling.h"
+#include "engine.h"
+
+XBT_LOG_NEW_DEFAULT_SUBCATEGORY(engine, EnsembleSched, "Logging specific to the simulation engines");
+
+/* Parameters of the default network model of SimGrid (LV08) */
+#define LV08_LATENCY_FACTOR 13.01
+#define LV08_BANDWIDTH_FACTOR 0.97
+#define TCP_GAMMA 4194304.0
+
+static engine_type_t engine_type = ENGINE_SIMGRID;
+static int locality = 0;   /* 1 if the transfers within a VM are skipped (see handle_local_transfers) */
+
+/* State of the native engine. Events are the completions of the running tasks, in a binary min-heap ordered by time.
+ * Tasks that complete at the same time are handled in the order they started.
+ */
+typedef struct {
+  double time;
+  unsigned long seq;
+  SD_task_t task;
+} event_t;
+
+static double native_clock = 0.;
+static event_t *events = NULL;
+static int nevents = 0;
+static int max_events = 0;
+static unsigned long next_seq = 0;
+static xbt_dynar_t completed = NULL;  /* tasks returned by the last call to engine_simulate */
+
+void engine_init(engine_type_t type, int skip_local_transfers){
+  engine_type = type;
+  locality = skip_local_transfers;
+  if (type != ENGINE_NATIVE)
+    return;
+
+  max_events = 1024;
+  events = (event_t *) malloc (max_events * sizeof(event_t));
+  completed = xbt_dynar_new(sizeof(SD_task_t), NULL);
+}
+
+void engine_exit(){
+  free(events);
+  events = NULL;
+  nevents = max_events = 0;
+  if (completed)
+    xbt_dynar_free(&completed);
+}
+
+engine_type_t engine_get_type(){
+  return engine_type;
+}
+
+engine_type_t getEngineByName(const char *name){
+  if (!strcmp(name, "simgrid"))
+    return ENGINE_SIMGRID;
+  else if (!strcmp(name, "native"))
+    return ENGINE_NATIVE;
+  else
+    xbt_die("Unknown engine: %s", name);
+}
+
+/*****************************************************************************/
+/*****************************************************************************/
+/**************                 Native engine                   **************/
+/*****************************************************************************/
+/*****************************************************************************/
+
+static int event_before(event_t *e1, event_t *e2){
+  return (e1->time < e2->time) || (e1->time == e2->time && e1->seq < e2->seq);
+}
+
+static void event_push(double time, SD_task_t task){
+  int i = nevents++;
+  event_t event = {time, next_seq++, task};
+
+  if (nevents > max_events){
+    max_events *= 2;
+    events = (event_t *) realloc (events, max_events * sizeof(event_t));
+  }
+  while (i > 0 && event_before(&event, &(events[(i - 1) / 2]))){
+    events[i] = events[(i - 1) / 2];
+    i = (i - 1) / 2;
+  }
+  events[i] = event;
+}
+
+static SD_task_t event_pop(){
+  SD_task_t task = events[0].task;
+  event_t last = events[--nevents];
+  int i = 0, child;
+
+  while ((child = 2 * i + 1) < nevents){
+    if (child + 1 < nevents && event_before(&(events[child + 1]), &(events[child])))
+      child++;
+    if (!event_before(&(events[child]), &last))
+      break;
+    events[i] = events[child];
+    i = child;
+  }
+  events[i] = last;
+  return task;
+}
+
+/* Duration of a transfer on an idle network, as in the LV08 model of SimGrid: the latency of the route is weighted,
+ * and the rate is bounded by the TCP window. A transfer within a VM follows the route from the VM to itself, as in
+ * SimGrid, unless data locality is enabled. It then takes no time, as SimGrid does not simulate it either.
+ */
+static double transfer_time(double size, sg_host_t source, sg_host_t destination){
+  double latency, bandwidth;
+
+  if (locality && source == destination)
+    return 0.;
+  latency = SD_route_get_latency(source, destination);
+  bandwidth = SD_route_get_bandwidth(source, destination) * LV08_BANDWIDTH_FACTOR;
+  if (latency > 0)
+    bandwidth = MIN(bandwidth, TCP_GAMMA / (2 * latency));
+  return latency * LV08_LATENCY_FACTOR + size / bandwidth;
+}
+
+/* Time at which all the inputs of a scheduled task whose compute parents are done are available. A transfer starts
+ * when its source is done and its destination is scheduled, as SimGrid only schedules a transfer once both ends are.
+ * Transfers are read from the compute-only dependency graph, in which the transfers between two tasks are folded in
+ * the largest one, so that they are handled the same way whether they are SimDAG tasks or not (see workflow.h).
+ */
+static double inputs_available_at(TaskAttribute attr){
+  int i;
+  double available_at = attr->scheduled_at;
+  TaskAttribute source_attr;
+
+  for (i = 0; i < attr->nparents; i++){
+    source_attr = (TaskAttribute) SD_task_get_data(attr->parents[i]);
+    if (attr->input_sizes[i] >= 0)
+      available_at = MAX(available_at, MAX(source_attr->finish_time, attr->scheduled_at) +
+                         transfer_time(attr->input_sizes[i], source_attr->host, attr->host));
+    else
+      available_at = MAX(available_at, source_attr->finish_time);
+  }
+  return available_at;
+}
+
+/* Start a scheduled task whose compute parents are all done: it runs alone on its VM, once booted, as soon as its
+ * inputs are available.
+ */
+static void native_start(SD_task_t task, TaskAttribute attr){
+  HostAttribute host_attr = (HostAttribute) sg_host_user(attr->host);
+
+  attr->start_time = MAX(inputs_available_at(attr), host_attr->booted_at);
+  attr->finish_time = attr->start_time + SD_task_get_amount(task) / sg_host_speed(attr->host);
+  attr->state = SD_RUNNING;
+  event_push(attr->finish_time, task);
+}
+
+static void native_complete(SD_task_t task){
+  int i;
+  TaskAttribute attr = (TaskAttribute) SD_task_get_data(task), child_attr;
+
+  attr->state = SD_DONE;
+  for (i = 0; i < attr->nchildren; i++){
+    child_attr = (TaskAttribute) SD_task_get_data(attr->children[i]);
+    if (!--child_attr->unfinished_parents && child_attr->state == SD_SCHEDULED)
+      native_start(attr->children[i], child_attr);
+  }
+}
+
+/* Let the simulation run until the next completions, for at most how_long seconds (until all the tasks are done if
+ * how_long is negative). The tasks that complete at the same time are returned together, while those that they
+ * release and that complete at that time too are returned by the next call, as SimGrid does.
+ */
+static xbt_dynar_t native_simulate(double how_long){
+  double horizon = (how_long < 0) ? DBL_MAX : native_clock + how_long;
+  unsigned int i, first;
+
+  xbt_dynar_reset(completed);
+  if (!nevents || events[0].time > horizon){
+    if (how_long >= 0)
+      native_clock = horizon;
+    return completed;
+  }
+
+  do {
+    native_clock = events[0].time;
+    first = xbt_dynar_length(completed);
+    while (nevents && events[0].time == native_clock)
+      xbt_dynar_push_as(completed, SD_task_t, event_pop());
+    for (i = first; i < xbt_dynar_length(completed); i++)
+      native_complete(xbt_dynar_get_as(completed, i, SD_task_t));
+  } while (how_long < 0 && nevents);
+
+  return completed;
+}
+
+/*****************************************************************************/
+/*****************************************************************************/
+/**************               Engine entry points               **************/
+/*****************************************************************************/
+/*****************************************************************************/
+
+double engine_get_clock(){
+  return (engine_type == ENGINE_NATIVE) ? native_clock : SD_get_clock();
+}
+
+xbt_dynar_t engine_simulate(double how_long){
+  return (engine_type == ENGINE_NATIVE) ? native_simulate(how_long) : SD_simulate(how_long);
+}
+
+/* Schedule a compute task on a host, after the tasks already scheduled there */
+void engine_schedule(SD_task_t task, sg_host_t host){
+  TaskAttribute attr;
+
+  if (engine_type != ENGINE_NATIVE){
+    SD_task_schedulel(task, 1, host);
+    handle_resource_dependency(host, task);
+    return;
+  }
+
+  attr = (TaskAttribute) SD_task_get_data(task);
+  attr->state = SD_SCHEDULED;
+  attr->host = host;
+  attr->scheduled_at = native_clock;
+  sg_host_set_last_scheduled_task(host, task);
+  if (!attr->unfinished_parents)
+    native_start(task, attr);
+}
+
+e_SD_task_state_t engine_task_get_state(SD_task_t task){
+  if (engine_type != ENGINE_NATIVE)
+    return SD_task_get_state(task);
+  return ((TaskAttribute) SD_task_get_data(task))->state;
+}
+
+/* Host a compute task is scheduled on, NULL if it is not scheduled */
+sg_host_t engine_task_get_host(SD_task_t task){
+  if (engine_type != ENGINE_NATIVE)
+    return SD_task_get_workstation_count(task) ? SD_task_get_workstation_list(task)[0] : NULL;
+  return ((TaskAttribute) SD_task_get_data(task))->host;
+}
+
+double engine_task_get_start_time(SD_task_t task){
+  if (engine_type != ENGINE_NATIVE)
+    return SD_task_get_start_time(task);
+  return ((TaskAttribute) SD_task_get_data(task))->start_time;
+}
+
+double engine_task_get_finish_time(SD_task_t task){
+  if (engine_type != ENGINE_NATIVE)
+    return SD_task_get_finish_time(task);
+  return ((TaskAttribute) SD_task_get_data(task))->finish_time;
+}
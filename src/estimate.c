@@ -0,0 +1,147 @@
+/*
+ * Copyright (c) Centre de Calcul de l'IN2P3 du CNRS
+ * Contributor(s) : Frédéric SUTER (2012-2016)
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the license (GNU LGPL) which comes with this package.
+ */
+#include <stdlib.h>
+#include <math.h>
+#include "xbt.h"
+#include "simgrid/simdag.h"
+#include "dax.h"
+#include "arrival.h"
+#include "estimate.h"
+
+XBT_LOG_NEW_DEFAULT_SUBCATEGORY(estimate, EnsembleSched, "Logging specific to the estimation of simulation results");
+
+/* Candidate DAXes for the knapsack bounds, with their weight (shortest path) and value (contribution to the score) */
+typedef struct {
+  double weight;
+  double value;
+} candidate_t;
+
+/* Sort candidates by decreasing value per unit of weight. Candidates without weight come first. */
+static int valueCompareCandidates(const void *c1, const void *c2){
+  const candidate_t *a = (const candidate_t *) c1, *b = (const candidate_t *) c2;
+
+  if (a->value * b->weight > b->value * a->weight)
+    return -1;
+  if (a->value * b->weight < b->value * a->weight)
+    return 1;
+  return (a->weight > b->weight) - (a->weight < b->weight);
+}
+
+/* Sort candidates by increasing weight */
+static int weightCompareCandidates(const void *c1, const void *c2){
+  const candidate_t *a = (const candidate_t *) c1, *b = (const candidate_t *) c2;
+
+  return (a->weight > b->weight) - (a->weight < b->weight);
+}
+
+/* Compute the bounds of a simulation of the loaded DAXes, whose priorities have to be assigned:
+ *  - A DAX counts in the score if and only if its end task is scheduled before the deadline (see dpds_settle_daxes).
+ *    This requires a chain of tasks from the root to a parent of the end task to be done, i.e., at least the shortest
+ *    path of the DAX. No task starts before the provisioning delay of the first VMs, and at most n VMs run at the same
+ *    time: n VMs are started by DPDS and WA-DPDS (see dpds_initial_VMs), that start new ones up to vmax times this
+ *    number, and SPSS may use the whole platform. The shortest paths of the DAXes that count thus fit in n VMs
+ *    running at the highest speed of the platform from the provisioning delay to the deadline. The score and the
+ *    number of completed DAXes are bounded by the fractional and integral solutions of the corresponding knapsack
+ *    problems, respectively.
+ *  - DPDS and WA-DPDS bill at least one hour for each VM started at the beginning.
+ *  - DPDS only stops before the deadline when all the DAXes are completed, i.e., after their critical paths and the
+ *    whole work have been executed. A run stopped by --early-abort does not report its makespan and cost, that are not
+ *    checked then. WA-DPDS may reject all the DAXes and SPSS may plan none of them, hence no lower bound of their
+ *    makespan.
+ * Transfers are ignored, which keeps the bounds conservative.
+ */
+void estimate_simulation(scheduling_globals_t globals, estimate_t estimate){
+  int i, ncandidates = 0, nVM = 0, nVMs;
+  double speed = 0., total_capacity, capacity, work = 0., critical_path = 0., start = globals->provisioning_delay;
+  const sg_host_t *hosts = sg_host_list();
+  candidate_t *candidates;
+  DaxDescriptor dax;
+
+  xbt_assert(!get_number_of_pending_arrivals(), "Simulation results cannot be estimated in online mode");
+
+  for (i = 0; i < sg_host_count(); i++)
+    speed = MAX(speed, sg_host_speed(hosts[i]));
+  if (globals->alg == SPSS){
+    nVMs = sg_host_count();
+  } else {
+    nVM = dpds_initial_VMs(globals);
+    nVMs = MIN(sg_host_count(), MAX(nVM, (int) ceil(globals->vmax * nVM)));
+  }
+  /* Leave room for the rounding errors of the simulation */
+  total_capacity = nVMs * speed * MAX(0., globals->deadline - start) * (1 + 1e-9) + speed * 0.00001;
+
+  /* Candidates are the DAXes whose shortest path can be executed before the deadline */
+  candidates = (candidate_t *) calloc (get_number_of_daxes(), sizeof(candidate_t));
+  for (i = 0; i < get_number_of_daxes(); i++){
+    dax = get_dax_descriptor(i);
+    work += dax->remaining_work;
+    critical_path = MAX(critical_path, dax->critical_path);
+    if (start + dax->shortest_path / speed - globals->deadline > 0.00001)
+      continue;
+    candidates[ncandidates].weight = dax->shortest_path;
+    candidates[ncandidates].value = pow(2.0, -dax->priority);
+    ncandidates++;
+  }
+  estimate->max_score = 0.;
+  capacity = total_capacity;
+  qsort(candidates, ncandidates, sizeof(candidate_t), valueCompareCandidates);
+  for (i = 0; i < ncandidates; i++){
+    if (candidates[i].weight > capacity){
+      estimate->max_score += candidates[i].value * capacity / candidates[i].weight;
+      break;
+    }
+    capacity -= candidates[i].weight;
+    estimate->max_score += candidates[i].value;
+  }
+
+  estimate->max_completed_daxes = 0;
+  capacity = total_capacity;
+  qsort(candidates, ncandidates, sizeof(candidate_t), weightCompareCandidates);
+  for (i = 0; i < ncandidates && candidates[i].weight <= capacity; i++){
+    capacity -= candidates[i].weight;
+    estimate->max_completed_daxes++;
+  }
+  free(candidates);
+
+  estimate->min_cost = nVM * globals->price;
+
+  estimate->min_makespan = 0.;
+  if (globals->alg == DPDS){
+    estimate->min_makespan = MIN(globals->deadline - 0.00001,
+                                 start + MAX(critical_path / speed, work / (nVMs * speed)));
+  }
+
+  XBT_VERB("Estimate: score <= %f, completed DAXes <= %d, cost >= $%.2f, makespan >= %.3f", estimate->max_score,
+           estimate->max_completed_daxes, estimate->min_cost, estimate->min_makespan);
+}
+
+/* Check that the result of a simulation is within the bounds computed beforehand. Return 1 if it is, 0 otherwise. */
+int check_estimate(estimate_t estimate, simulation_result_t result){
+  int valid = 1;
+
+  if (result->score > estimate->max_score + 1e-9){
+    XBT_ERROR("Estimate check: score %f above its upper bound %f", result->score, estimate->max_score);
+    valid = 0;
+  }
+  if (result->completed_daxes > estimate->max_completed_daxes){
+    XBT_ERROR("Estimate check: %d completed DAXes, above the upper bound of %d", result->completed_daxes,
+              estimate->max_completed_daxes);
+    valid = 0;
+  }
+  /* The makespan and cost of an early aborted run are those at the time it stopped, hence not bounded */
+  if (result->aborted)
+    return valid;
+  if (result->total_cost < estimate->min_cost - 1e-6){
+    XBT_ERROR("Estimate check: cost $%.2f below its lower bound $%.2f", result->total_cost, estimate->min_cost);
+    valid = 0;
+  }
+  if (result->makespan < estimate->min_makespan - 1e-6){
+    XBT_ERROR("Estimate check: makespan %.3f below its lower bound %.3f", result->makespan, estimate->min_makespan);
+    valid = 0;
+  }
+  return valid;
+}
@@ -0,0 +1,186 @@
+/*
+ * Copyright (c) Centre de Calcul de l'IN2P3 du CNRS
+ * Contributor(s) : Frédéric SUTER (2012-2016)
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the license (GNU LGPL) which comes with this package.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <float.h>
+#include "xbt.h"
+#include "simgrid/simdag.h"
+#include "sweep.h"
+#include "explore.h"
+#include "engine.h"
+
+XBT_LOG_NEW_DEFAULT_SUBCATEGORY(explore, EnsembleSched, "Logging specific to what-if explorations");
+
+/* Variants of the policy and state of the exploration. Unlike in a sweep, the parent process runs the simulation up
+ * to the last branching point, and branches are forked from that simulation.
+ */
+static xbt_dynar_t variants = NULL;
+static int nforked = 0;
+static int is_branch = 0;
+static worker_pool_t pool = NULL;
+static struct _simulation_result *results = NULL;
+static int *success = NULL;
+
+/* Read the variants of the policy. Each non empty line of the file (apart from comments starting by '#') describes a
+ * variant as a list of key=value pairs among at, period, uh and ul, e.g.,
+ *   at=7200 uh=80 ul=60
+ * Parameters that are not set keep the value given on the command line, and branching happens at the first
+ * provisioning period by default.
+ */
+void explore_read_variants(const char *filename, scheduling_globals_t base, int max_workers){
+  char line[4096], *token, *value, *saveptr;
+  int line_number = 0;
+  PolicyVariant variant;
+  FILE *f = fopen(filename, "r");
+
+  if (!f)
+    xbt_die("Cannot open the exploration file %s", filename);
+
+  variants = xbt_dynar_new(sizeof(PolicyVariant), NULL);
+  while (fgets(line, sizeof(line), f)){
+    line_number++;
+    if ((token = strchr(line, '#')))
+      *token = '\0';
+    variant.at = 0.;
+    variant.period = base->period;
+    variant.uh = base->uh;
+    variant.ul = base->ul;
+    token = strtok_r(line, " \t\r\n", &saveptr);
+    if (!token)
+      continue;
+    for (; token; token = strtok_r(NULL, " \t\r\n", &saveptr)){
+      value = strchr(token, '=');
+      if (!value)
+        xbt_die("%s:%d: '%s' is not a key=value pair", filename, line_number, token);
+      *value++ = '\0';
+      if (!strcmp(token, "at"))
+        variant.at = MAX(0., atof(value));
+      else if (!strcmp(token, "period"))
+        variant.period = atof(value);
+      else if (!strcmp(token, "uh"))
+        variant.uh = atof(value);
+      else if (!strcmp(token, "ul"))
+        variant.ul = atof(value);
+      else
+        xbt_die("%s:%d: unknown parameter '%s' (only at, period, uh and ul can vary)", filename, line_number, token);
+    }
+    if (variant.period <= 0)
+      xbt_die("%s:%d: the period has to be positive", filename, line_number);
+    xbt_dynar_push(variants, &variant);
+  }
+  fclose(f);
+
+  if (xbt_dynar_is_empty(variants))
+    xbt_die("No variant in the exploration file %s", filename);
+
+  results = calloc (xbt_dynar_length(variants), sizeof(struct _simulation_result));
+  success = calloc (xbt_dynar_length(variants), sizeof(int));
+  pool = worker_pool_new(max_workers);
+}
+
+static void explore_wait(){
+  int job;
+  struct _simulation_result result;
+
+  if (worker_pool_wait(pool, &job, &result)){
+    results[job] = result;
+    success[job] = 1;
+  }
+}
+
+/* Called at each provisioning period, before the provisioning decision. Fork a branch for each variant whose branching
+ * time has come. In a branch, the variant is applied to the scheduling parameters and 0 is returned. In the parent, 1
+ * is returned once all the branches have been forked and have completed, meaning that the simulation can stop there.
+ */
+int explore_branch_point(scheduling_globals_t globals){
+  unsigned int i;
+  PolicyVariant *variant;
+
+  if (!variants || is_branch)
+    return 0;
+
+  for (i = 0; i < xbt_dynar_length(variants); i++){
+    variant = (PolicyVariant *) xbt_dynar_get_ptr(variants, i);
+    if (variant->at < 0 || variant->at - engine_get_clock() > 0.00001)
+      continue;
+
+    while (worker_pool_is_full(pool))
+      explore_wait();
+    XBT_INFO("Branch %u (period=%g uh=%g ul=%g) forked at %.3f", i, variant->period, variant->uh, variant->ul,
+             engine_get_clock());
+    if (!worker_pool_fork(pool, i)){
+      /* Branch: apply the variant and let the simulation go on. Only the report matters. */
+      is_branch = 1;
+      xbt_log_control_set("root.thresh:critical");
+      globals->period = variant->period;
+      globals->uh = variant->uh;
+      globals->ul = variant->ul;
+      return 0;
+    }
+    /* A negative branching time marks the variant as forked */
+    variant->at = -1.;
+    nforked++;
+  }
+
+  if (nforked < xbt_dynar_length(variants))
+    return 0;
+
+  while (!worker_pool_is_empty(pool))
+    explore_wait();
+  return 1;
+}
+
+/* Earliest branching time that has not been reached yet, DBL_MAX if none. Periods before it may be skipped. */
+double explore_next_branch_time(){
+  unsigned int i;
+  double next = DBL_MAX;
+  PolicyVariant *variant;
+
+  if (!variants || is_branch)
+    return DBL_MAX;
+  for (i = 0; i < xbt_dynar_length(variants); i++){
+    variant = (PolicyVariant *) xbt_dynar_get_ptr(variants, i);
+    if (variant->at >= 0)
+      next = MIN(next, variant->at);
+  }
+  return next;
+}
+
+int explore_is_branch(){
+  return is_branch;
+}
+
+/* Display the results of all the branches. Variants whose branching time was never reached share the result of the
+ * simulation run by the parent process, as they did not change anything.
+ */
+void explore_report(simulation_result_t parent_result){
+  unsigned int i;
+  PolicyVariant *variant;
+
+  while (!worker_pool_is_empty(pool))
+    explore_wait();
+
+  printf("#branch\tperiod\tuh\tul\tmakespan\tcompleted\tdaxes\tcost\tscore\n");
+  for (i = 0; i < xbt_dynar_length(variants); i++){
+    variant = (PolicyVariant *) xbt_dynar_get_ptr(variants, i);
+    printf("%u\t%g\t%g\t%g\t", i, variant->period, variant->uh, variant->ul);
+    if (variant->at >= 0){
+      results[i] = *parent_result;
+      success[i] = 1;
+    }
+    if (success[i])
+      print_simulation_result(&(results[i]));
+    else
+      printf("failed\tfailed\tfailed\tfailed\tfailed\n");
+  }
+
+  worker_pool_free(&pool);
+  free(results);
+  free(success);
+  xbt_dynar_free(&variants);
+}
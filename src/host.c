@@ -8,33 +8,116 @@
 #include <stdio.h>
 #include <math.h>
 #include "host.h"
+#include "billing.h"
 #include "scheduling.h"
 #include "task.h"
+#include "trace.h"
+#include "rng.h"
+#include "engine.h"
 #include "xbt.h"
 #include "simgrid/simdag.h"
 
 XBT_LOG_NEW_DEFAULT_SUBCATEGORY(host, EnsembleSched, "Logging specific to hosts");
 
+/* Sets of hosts/VMs in each state (OFF, idle, busy). They are maintained incrementally when the state of a host
+ * changes, which avoids scanning the whole platform to find VMs in a given state. Each host stores its position in
+ * the set it belongs to, so that insertion, removal, count and random selection are all done in constant time.
+ */
+typedef struct _VMSet {
+  sg_host_t *hosts;
+  int size;
+  int capacity;
+} VMSet;
+
+static VMSet VM_sets[3];
+
+static vm_state_t get_VM_state(HostAttribute attr){
+  if (!attr->on_off)
+    return VM_OFF;
+  return attr->idle_busy ? VM_BUSY : VM_IDLE;
+}
+
+static void VM_set_insert(vm_state_t state, sg_host_t host){
+  VMSet *set = &(VM_sets[state]);
+
+  if (set->size == set->capacity){
+    set->capacity = set->capacity ? 2*set->capacity : 64;
+    set->hosts = (sg_host_t *) realloc (set->hosts, set->capacity * sizeof(sg_host_t));
+  }
+  ((HostAttribute) sg_host_user(host))->set_index = set->size;
+  set->hosts[set->size++] = host;
+}
+
+/* Remove a host from a set by moving the last element of the set at its position */
+static void VM_set_remove(vm_state_t state, sg_host_t host){
+  VMSet *set = &(VM_sets[state]);
+  int i = ((HostAttribute) sg_host_user(host))->set_index;
+
+  set->size--;
+  if (i != set->size){
+    set->hosts[i] = set->hosts[set->size];
+    ((HostAttribute) sg_host_user(set->hosts[i]))->set_index = i;
+  }
+}
+
+/* Update the state attributes of a host and move it to the corresponding set if its state changed */
+static void sg_host_set_state(sg_host_t host, int on_off, int idle_busy){
+  HostAttribute attr = (HostAttribute) sg_host_user(host);
+  vm_state_t old_state = get_VM_state(attr);
+
+  attr->on_off = on_off;
+  attr->idle_busy = idle_busy;
+  if (get_VM_state(attr) != old_state){
+    VM_set_remove(old_state, host);
+    VM_set_insert(get_VM_state(attr), host);
+  }
+}
+
 /*****************************************************************************/
 /*****************************************************************************/
 /**************          Attribute management functions         **************/
 /*****************************************************************************/
 /*****************************************************************************/
 
-void sg_host_allocate_attribute(sg_host_t host){
-  HostAttribute data;
-  data = calloc(1,sizeof(struct _HostAttribute));
-  data->total_cost = 0;
-  /* Set the hosts to off and idle at the beginning */
-  data->on_off = 0;
-  data->idle_busy = 0;
-  data->booting=NULL;
-  sg_host_user_set(host, data);
+/* The attributes of all the hosts are allocated at once, in a single array, in the order of the given list of hosts.
+ * The sets of VMs are also sized for the whole platform.
+ */
+static struct _HostAttribute *host_attributes = NULL;
+
+void sg_host_allocate_attributes(const sg_host_t *hosts, int nhosts){
+  int i;
+
+  host_attributes = (struct _HostAttribute *) calloc (nhosts, sizeof(struct _HostAttribute));
+  for (i = 0; i < 3; i++){
+    VM_sets[i].hosts = (sg_host_t *) calloc (nhosts, sizeof(sg_host_t));
+    VM_sets[i].size = 0;
+    VM_sets[i].capacity = nhosts;
+  }
+
+  for (i = 0; i < nhosts; i++){
+    /* Set the hosts to off and idle at the beginning */
+    host_attributes[i].on_off = 0;
+    host_attributes[i].idle_busy = 0;
+    host_attributes[i].booting = NULL;
+    sg_host_user_set(hosts[i], &(host_attributes[i]));
+    VM_set_insert(VM_OFF, hosts[i]);
+  }
 }
 
-void sg_host_free_attribute(sg_host_t host){
-  free(sg_host_user(host));
-  sg_host_user_set(host, NULL);
+void sg_host_free_attributes(const sg_host_t *hosts, int nhosts){
+  int i;
+
+  for (i = 0; i < nhosts; i++)
+    sg_host_user_set(hosts[i], NULL);
+  free(host_attributes);
+  host_attributes = NULL;
+
+  for (i = 0; i < 3; i++){
+    free(VM_sets[i].hosts);
+    VM_sets[i].hosts = NULL;
+    VM_sets[i].size = 0;
+    VM_sets[i].capacity = 0;
+  }
 }
 
 void sg_host_set_price(sg_host_t host, double price){
@@ -74,14 +157,12 @@ void sg_host_set_last_scheduled_task(sg_host_t host, SD_task_t task){
 
 void sg_host_set_to_idle(sg_host_t host){
   HostAttribute attr = (HostAttribute) sg_host_user(host);
-  attr->idle_busy=0;
-  sg_host_user_set(host, attr);
+  sg_host_set_state(host, attr->on_off, 0);
 }
 
 void sg_host_set_to_busy(sg_host_t host){
   HostAttribute attr = (HostAttribute) sg_host_user(host);
-  attr->idle_busy=1;
-  sg_host_user_set(host, attr);
+  sg_host_set_state(host, attr->on_off, 1);
 }
 
 /* compare host names w.r.t. the lexicographic order (Increasing) */
@@ -98,8 +179,9 @@ int nameCompareHosts(const void *n1, const void *n2) {
 /* Activate a resource, i.e., act as if a VM is started on a host. This amounts to :
  * - setting attributes to 'ON' and 'idle'
  * - Resetting the start time of the host to the current time
- * - bill at least the first hour
- * If a provisioning delay is needed before a VM is actually available for executing task, this function :
+ * - bill at least the first hour (done by the budget ledger)
+ * If a provisioning delay is needed before a VM is actually available for executing task, this function (with the
+ * SimGrid engine):
  * - creates a task whose name is "Booting " followed by the host name
  * - schedules this task on the host
  * - Ensures that no compute task can be executed before the completion of this booting task.
@@ -108,41 +190,44 @@ void sg_host_start(sg_host_t host){
   HostAttribute attr = (HostAttribute) sg_host_user(host);
   char name[1024];
 
-  attr->on_off = 1;
-  attr->idle_busy = 0;
-  attr->start_time = SD_get_clock();
-  attr->total_cost += attr->price;
+  sg_host_set_state(host, 1, 0);
+  attr->start_time = engine_get_clock();
+  billing_start_VM(host);
+  trace_VM_start(host);
   if (attr->provisioning_delay){
-    sprintf(name,"Booting %s", sg_host_get_name(host));
-
-    attr->booting = SD_task_create_comp_seq(name, NULL, attr->provisioning_delay*sg_host_speed(host));
-    SD_task_schedulel(attr->booting, 1, host);
     attr->available_at += attr->provisioning_delay;
-    handle_resource_dependency(host, attr->booting);
+    if (engine_get_type() == ENGINE_NATIVE){
+      /* The native engine only needs to know when the VM is booted */
+      attr->booted_at = attr->start_time + attr->provisioning_delay;
+    } else {
+      sprintf(name,"Booting %s", sg_host_get_name(host));
+
+      attr->booting = SD_task_create_comp_seq(name, NULL, attr->provisioning_delay*sg_host_speed(host));
+      SD_task_schedulel(attr->booting, 1, host);
+      handle_resource_dependency(host, attr->booting);
+    }
   }
-  XBT_DEBUG("VM started on %s: Total cost is now $%f for this host", sg_host_get_name(host), attr->total_cost);
   sg_host_user_set(host, attr);
 }
 
 /* Disable a resource, i.e., act as a VM is terminated on a host. This amounts to:
  * - setting attributes to 'OFF'
  * - Resetting the start time of the host to 0 (just in case)
- * - Do some accounting. The time (in seconds) spent since the last time host/VM was started (state set to ON) is
- *   rounded down (as the first hour is charged on activation) and multiplied by the hour price.
+ * - Do some accounting. The budget ledger settles the hours started since the last time host/VM was started (state
+ *   set to ON) that have not been charged yet.
  * If a provisioning delay is needed before a VM is actually available for executing task, this function destroys the
  * booting task created by the sg_host_start function.
 */
 void sg_host_terminate(sg_host_t host){
   HostAttribute attr = (HostAttribute) sg_host_user(host);
-  double duration = SD_get_clock() - attr->start_time;
 
   if (attr->booting)
     SD_task_destroy(attr->booting);
-  attr->on_off = 0;
+  sg_host_set_state(host, 0, attr->idle_busy);
+  billing_terminate_VM(host);
+  trace_VM_terminate(host);
   attr->start_time = 0.0;
-  attr->total_cost += ((((int) duration / 3600)) * attr->price);
 
-  XBT_DEBUG("VM stopped on %s: Total cost is now $%f for this host", sg_host_get_name(host), attr->total_cost);
   sg_host_user_set(host, attr);
 }
 
@@ -153,62 +238,49 @@ int is_on_and_idle(sg_host_t host){
   return (attr->on_off && !attr->idle_busy);
 }
 
+/* Number of hosts/VMs that are ON and idle. Constant time. */
+int get_number_of_idle_VMs(){
+  return VM_sets[VM_IDLE].size;
+}
+
+/* Number of hosts/VMs that are ON, either idle or busy. Constant time. */
+int get_number_of_running_VMs(){
+  return VM_sets[VM_IDLE].size + VM_sets[VM_BUSY].size;
+}
+
 /* Build an array that contains all the idle hosts/VMs in the platform */
 xbt_dynar_t get_idle_VMs(){
   int i;
-  const sg_host_t *hosts = sg_host_list();
-  int nhosts = sg_host_count();
   xbt_dynar_t idleVMs = xbt_dynar_new(sizeof(sg_host_t), NULL);
 
-  for (i = 0; i < nhosts; i++){
-    if (is_on_and_idle(hosts[i]))
-      xbt_dynar_push(idleVMs, &(hosts[i]));
-  }
+  for (i = 0; i < VM_sets[VM_IDLE].size; i++)
+    xbt_dynar_push(idleVMs, &(VM_sets[VM_IDLE].hosts[i]));
 
   return idleVMs;
 }
 
 /* Build an array that contains all the busy hosts/VMs in the platform */
-xbt_dynar_t get_running_VMs(){
+xbt_dynar_t get_busy_VMs(){
   int i;
-  const sg_host_t *hosts = sg_host_list ();
-  int nhosts = sg_host_count ();
-  HostAttribute attr;
-  xbt_dynar_t runningVMs = xbt_dynar_new(sizeof(sg_host_t), NULL);
+  xbt_dynar_t busyVMs = xbt_dynar_new(sizeof(sg_host_t), NULL);
 
-  for (i = 0; i < nhosts; i++){
-    attr = sg_host_user(hosts[i]);
-    if (attr->on_off)
-      xbt_dynar_push(runningVMs, &(hosts[i]));
-  }
+  for (i = 0; i < VM_sets[VM_BUSY].size; i++)
+    xbt_dynar_push(busyVMs, &(VM_sets[VM_BUSY].hosts[i]));
 
-  return runningVMs;
+  return busyVMs;
 }
 
-/* Build an array that contains all the hosts/VMs that are "approaching their hourly billing cycle" in the platform
- * Remark: In the paper by Malawski et al., no details are provided about when a VM is "approaching" the end of a
- * paid hour. This is hard coded in the source code of cloudworkflowsim: 90s (provisioner interval, a.k.a period) +
- * 1s (optimistic deprovisioning delay)
- */
-xbt_dynar_t get_ending_billing_cycle_VMs(double period, double margin){
+/* Build an array that contains all the running (idle or busy) hosts/VMs in the platform */
+xbt_dynar_t get_running_VMs(){
   int i;
-  const sg_host_t *hosts = sg_host_list ();
-  int nhosts = sg_host_count ();
-  HostAttribute attr;
-  xbt_dynar_t endingVMs = xbt_dynar_new(sizeof(sg_host_t), NULL);
+  xbt_dynar_t runningVMs = xbt_dynar_new(sizeof(sg_host_t), NULL);
 
-  for (i = 0; i < nhosts; i++){
-    attr = sg_host_user(hosts[i]);
-    /* To determine how far a VM is from the end of a hourly billing cycle, we compute the time spent between the
-     * start of the VM and the current, and keep the time spent in the last hour. As times are expressed in seconds,
-     * it amounts to computing the modulo to 3600s=1h. Then the current VM is selected if this modulo is greater than
-     * 3600-period-margin.
-     */
-    if (attr->on_off && ((int)(SD_get_clock() - attr->start_time) % 3600) > (3600-period-margin))
-      xbt_dynar_push(endingVMs, &(hosts[i]));
-  }
+  for (i = 0; i < VM_sets[VM_IDLE].size; i++)
+    xbt_dynar_push(runningVMs, &(VM_sets[VM_IDLE].hosts[i]));
+  for (i = 0; i < VM_sets[VM_BUSY].size; i++)
+    xbt_dynar_push(runningVMs, &(VM_sets[VM_BUSY].hosts[i]));
 
-  return endingVMs;
+  return runningVMs;
 }
 
 /* Build the set of hosts/VMs that have to be terminated. This function selects how_many VMs from the source set of
@@ -252,68 +324,75 @@ xbt_dynar_t find_active_VMs_to_stop(int how_many, xbt_dynar_t source){
   return to_stop;
 }
 
-/* Return the first inactive host/VM (currently set to OFF) that we find in the platform.
+/* Number of times no VM could be started by find_inactive_VM_to_start during the current run */
+static int nfailed_starts = 0;
+
+int get_number_of_failed_VM_starts(){
+  return nfailed_starts;
+}
+
+/* Return an inactive host/VM (currently set to OFF). The last element of the set of inactive VMs is taken, which is
+ * done in constant time.
  * Remarks:
  * 1) Straightforward selection, all VMs are assumed to be similar
- * 2) It may happen that no such VM is found. This means that the platform file given as input of the simulator was
- *    too small. The simulation cannot continue while the size of the resource pool represented by the platform file
- *    is not increased.
+ * 2) It may happen that no such VM is found. This means that the platform given as input of the simulator is too
+ *    small. NULL is then returned and no VM is started. A pool described with --cloud is sized for all the
+ *    configurations to be run, so that this can only happen if its count is too small. Such a run fails: the program
+ *    exits with status 1, and workers of sweeps, replications and explorations report it as failed.
  */
 sg_host_t find_inactive_VM_to_start(){
-  int i=0;
-  const sg_host_t *hosts = sg_host_list ();
-  int nhosts = sg_host_count ();
-  HostAttribute attr;
-  sg_host_t host = NULL;
-
-  while (i < nhosts){
-    attr = sg_host_user(hosts[i]);
-    if (!attr->on_off){
-      host = hosts[i];
-      break;
-    }
-    i++;
-  }
-
-  if (!host){
-    xbt_die("Argh. We reached the pool limit. Have to increase the size of the cluster in the platform file.");
+  if (!VM_sets[VM_OFF].size){
+    XBT_WARN("The pool of VMs is exhausted. No VM can be started");
+    nfailed_starts++;
+    return NULL;
   }
 
-  return host;
+  return VM_sets[VM_OFF].hosts[VM_sets[VM_OFF].size - 1];
 }
 
 /* Determine the current utilization of VM in the system. This utilization is defined in the paper by Malawski et al.
  * as "the percentage of idle VMs over time".
  * The source code shows that it is the number of busy VMs divided by the total number of active VMs (busy and idle)
+ * Both numbers are directly read from the sets of VMs. If no VM is active, the utilization is 0.
  */
 double compute_current_VM_utilization(){
-  int i=0;
-  const sg_host_t *hosts = sg_host_list ();
-  int nhosts = sg_host_count ();
-  HostAttribute attr;
-  int nActiveVMs = 0, nBusyVMs = 0;
+  int nActiveVMs = get_number_of_running_VMs();
 
-  for (i = 0; i < nhosts; i++){
-    attr = sg_host_user(hosts[i]);
-    if (attr->on_off){
-      nActiveVMs++;
-      if (!attr->idle_busy)
-        nBusyVMs++;
-    }
-  }
-  return (100.*nBusyVMs)/nActiveVMs;
+  if (!nActiveVMs)
+    return 0.;
+
+  return (100.*VM_sets[VM_BUSY].size)/nActiveVMs;
 }
 
 
-/* Randomly select a host in an array. Rely on the rand function provided by math.h
- * Remark: This function actually removes the selected element from the array.
+/* Randomly select an idle host/VM. Rely on the stream of random numbers dedicated to this selection (see rng.h)
+ * Remark: The selected VM is NOT removed from the set of idle VMs. This is done when the VM is set to busy.
  */
-sg_host_t select_random(xbt_dynar_t hosts){
+sg_host_t select_random_idle_VM(){
   unsigned long i;
-  sg_host_t host=NULL;
-  int nhosts = xbt_dynar_length(hosts);
+  int nhosts = VM_sets[VM_IDLE].size;
+
+  if (!nhosts)
+    return NULL;
+
+  i = rng_uniform_int(RNG_VM_SELECTION, nhosts);
+  return VM_sets[VM_IDLE].hosts[i];
+}
 
-  i = (unsigned long) ((nhosts-1.)*rand()/(RAND_MAX+1.0));
-  xbt_dynar_remove_at(hosts, i, &host);
-  return host;
+/* Data locality: select an idle host/VM that executed one of the compute parents of a task, so that the data it
+ * produced does not have to be transferred. Parents are considered in the order of the compute graph. Return NULL if
+ * there is no such VM.
+ * Remark: As for select_random_idle_VM, the selected VM is NOT removed from the set of idle VMs.
+ */
+sg_host_t select_local_idle_VM(SD_task_t task){
+  int i;
+  SD_task_t *parents = SD_task_get_compute_parents(task);
+  sg_host_t host;
+
+  for (i = 0; i < SD_task_get_compute_parents_count(task); i++){
+    host = engine_task_get_host(parents[i]);
+    if (host && is_on_and_idle(host))
+      return host;
+  }
+  return NULL;
 }
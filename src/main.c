@@ -9,27 +9,51 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <math.h>
+#include <unistd.h>
+#include <sys/resource.h>
 
 #include "simgrid/simdag.h"
 #include "xbt.h"
 #include "dax.h"
 #include "task.h"
 #include "host.h"
+#include "billing.h"
+#include "workflow.h"
 #include "scheduling.h"
+#include "sweep.h"
+#include "trace.h"
+#include "stats.h"
+#include "arrival.h"
+#include "rng.h"
+#include "cloud.h"
+#include "explore.h"
+#include "estimate.h"
+#include "engine.h"
 
 XBT_LOG_NEW_DEFAULT_CATEGORY(EnsembleSched, "Logging specific to EnsembleSched");
 
 int main(int argc, char **argv) {
-  unsigned int flag, cursor, cursor2;
-  char *platform_file = NULL, *daxname = NULL, *priority=NULL;
+  unsigned int flag, cursor;
+  char *platform_file = NULL, *daxname = NULL, *daxfile = NULL, *priority=NULL, *cache_dir = NULL;
   int total_nhosts = 0;
   const sg_host_t *hosts = NULL;
-  xbt_dynar_t daxes = NULL, current_dax = NULL;
-  int completed_daxes = 0;
+  xbt_dynar_t daxes = NULL, current_dax = NULL, dax_files = NULL, dax_names = NULL;
+  xbt_dynar_t configurations;
+  char *sweep_file = NULL, *dump_file = NULL, *arrival_file = NULL, *cloud_description = NULL;
+  char *explore_file = NULL;
+  struct _CloudSpec cloud;
+  double arrival_rate = 0.;
+  trace_format_t dump_format = TRACE_CSV;
+  int repeat, jobs = 0, replications = 1, estimate_only = 0, status = 0;
+  engine_type_t engine = ENGINE_SIMGRID;
+  network_model_t network = NETWORK_FULL;
   SD_task_t task;
   scheduling_globals_t globals;
-  HostAttribute attr;
-  double total_cost = 0.0, score = 0.0;
+  struct _simulation_result result;
+  struct _estimate estimate;
+  struct rusage usage;
+  double load_time;
+  unsigned long ntasks = 0;
 
   SD_init(&argc, argv);
 
@@ -41,6 +65,8 @@ int main(int argc, char **argv) {
   globals = new_scheduling_globals();
 
   daxes = xbt_dynar_new(sizeof(xbt_dynar_t), NULL);
+  dax_files = xbt_dynar_new(sizeof(char*), NULL);
+  dax_names = xbt_dynar_new(sizeof(char*), NULL);
   opterr = 0;
 
   while (1){
@@ -56,8 +82,25 @@ int main(int argc, char **argv) {
         {"uh", 1, 0, 'i'},
         {"ul", 1, 0, 'j'},
         {"provisioning_delay", 1, 0, 'k'},
+        {"dax-cache", 1, 0, 'l'},
+        {"dax-repeat", 1, 0, 'm'},
+        {"sweep", 1, 0, 'n'},
+        {"jobs", 1, 0, 'o'},
         {"silent", 0, 0, 'y'},
         {"dump", 1, 0, 'z'},
+        {"dump-format", 1, 0, 'p'},
+        {"arrivals", 1, 0, 'q'},
+        {"poisson", 1, 0, 'r'},
+        {"fast-forward", 0, 0, 's'},
+        {"seed", 1, 0, 't'},
+        {"replications", 1, 0, 'u'},
+        {"cloud", 1, 0, 'v'},
+        {"explore", 1, 0, 'w'},
+        {"early-abort", 0, 0, 'x'},
+        {"estimate", 0, 0, 'A'},
+        {"engine", 1, 0, 'B'},
+        {"locality", 0, 0, 'C'},
+        {"network", 1, 0, 'D'},
         {0, 0, 0, 0}
     };
 
@@ -83,31 +126,14 @@ int main(int argc, char **argv) {
       globals->alg = getAlgorithmByName(optarg);
       break;
     case 'b':
+      /* The environment is created once all the options are known */
       platform_file = optarg;
-      SD_create_environment(platform_file);
-      total_nhosts = sg_host_count();
-      hosts = sg_host_list();
-
-      /* Sort the hosts by name for sake of simplicity */
-      qsort((void *)hosts,total_nhosts, sizeof(sg_host_t), nameCompareHosts);
-
-      for(cursor=0; cursor<total_nhosts; cursor++){
-        sg_host_allocate_attribute(hosts[cursor]);
-      }
       break;
     case 'c':
-      /* List of DAGs to schedule concurrently (just file names here) */
-      daxname = optarg;
-      XBT_DEBUG("Loading %s", daxname);
-      current_dax = SD_daxload(daxname);
-      xbt_dynar_foreach(current_dax,cursor,task) {
-        if (SD_task_get_kind(task) == SD_TASK_COMP_SEQ){
-          SD_task_watch(task, SD_DONE);
-        }
-        SD_task_allocate_attribute(task);
-        SD_task_set_dax_name(task, daxname);
-      }
-      xbt_dynar_push(daxes,&current_dax);
+      /* List of DAGs to schedule concurrently (just file names here). They are loaded once all the options are known */
+      xbt_dynar_push(dax_files, &optarg);
+      daxname = xbt_strdup(optarg);
+      xbt_dynar_push(dax_names, &daxname);
       break;
     case 'd':
       priority = optarg;
@@ -139,106 +165,306 @@ int main(int argc, char **argv) {
     case 'k':
       globals->provisioning_delay = atof(optarg);
       break;
+    case 'l':
+      cache_dir = optarg;
+      break;
+    case 'm':
+      /* Several instances of the same DAG (<file>:<number of instances>). Each instance is named after the file name
+       * followed by its rank, e.g., Montage_50.xml#3. The file is parsed only once.
+       */
+      daxname = strrchr(optarg, ':');
+      if (!daxname || (repeat = atoi(daxname + 1)) < 1)
+        xbt_die("Invalid argument for --dax-repeat: %s (expected <file>:<n>)", optarg);
+      *daxname = '\0';
+      for (cursor = 1; cursor <= repeat; cursor++){
+        xbt_dynar_push(dax_files, &optarg);
+        daxname = bprintf("%s#%u", optarg, cursor);
+        xbt_dynar_push(dax_names, &daxname);
+      }
+      break;
+    case 'n':
+      sweep_file = optarg;
+      break;
+    case 'o':
+      jobs = atoi(optarg);
+      break;
     case 'y':
       xbt_log_control_set("root.thresh:critical");
       break;
     case 'z':
+      dump_file = optarg;
+      break;
+    case 'p':
+      if (!strcmp(optarg, "csv"))
+        dump_format = TRACE_CSV;
+      else if (!strcmp(optarg, "binary"))
+        dump_format = TRACE_BINARY;
+      else
+        xbt_die("Unknown dump format.");
+      break;
+    case 'q':
+      arrival_file = optarg;
+      break;
+    case 'r':
+      arrival_rate = atof(optarg);
+      break;
+    case 's':
+      globals->fast_forward = 1;
+      break;
+    case 't':
+      globals->seed = strtoull(optarg, NULL, 10);
+      break;
+    case 'u':
+      replications = atoi(optarg);
+      if (replications < 1)
+        xbt_die("Invalid number of replications: %s", optarg);
+      break;
+    case 'v':
+      cloud_description = optarg;
+      break;
+    case 'w':
+      explore_file = optarg;
+      break;
+    case 'x':
+      globals->early_abort = 1;
+      break;
+    case 'A':
+      estimate_only = 1;
+      break;
+    case 'B':
+      engine = getEngineByName(optarg);
+      break;
+    case 'C':
+      globals->locality = 1;
+      break;
+    case 'D':
+      network = getNetworkModelByName(optarg);
       break;
     }
   }
-  /* Display some information about the current run */
-  XBT_INFO("Algorithm: %s",getAlgorithmName(globals->alg));
-  XBT_INFO("  Priority method: %s", globals->priority_method ? "SORTED" : "RANDOM");
-  XBT_INFO("  Dynamic provisioning period: %.0fs", globals->period);
-  XBT_INFO("  Lower utilization threshold: %.2f%%", globals->ul);
-  XBT_INFO("  Upper utilization threshold: %.2f%%", globals->uh);
-
-  XBT_INFO("Platform: %s (%zu potential VMs)", platform_file, sg_host_count());
-  XBT_INFO("  VM hourly cost: $%f", globals->price);
-  XBT_INFO("  VM provisioning delay: %.0fs", globals->provisioning_delay);
-  if (ceil(globals->budget / ((globals->deadline / 3600.) * globals->price)) > sg_host_count()){
-    xbt_die("The platform file doesn't have enough nodes. Stop here");
-  }
-  /* Assign price and provisioning delay to host/VM (for the sake of simplicity) */
-  for(cursor=0; cursor < total_nhosts; cursor++){
-    sg_host_set_price(hosts[cursor], globals->price);
-    sg_host_set_provisioning_delay(hosts[cursor], globals->provisioning_delay);
-  }
 
-  XBT_INFO("Ensemble: %lu DAXes", xbt_dynar_length(daxes));
-  /* Assign priorities to the DAXes composing the ensemble according to the chosen method: RANDOM (default) or SORTED.
-   * Then display the result.
+  /* The early abort settles the DAXes at the end of the provisioning periods, that --fast-forward skips */
+  if (globals->fast_forward && globals->early_abort)
+    xbt_die("--fast-forward and --early-abort are mutually exclusive");
+
+  /* Create the environment, either from a platform file or from a compact description of the cloud. In the latter
+   * case, the pool of VMs is sized from the budget.
    */
-  assign_dax_priorities(daxes, globals->priority_method);
-  xbt_dynar_foreach(daxes, cursor, current_dax){
-     task = get_root(current_dax);
-     XBT_INFO("  %s", SD_task_get_dax_name(task));
-     XBT_INFO("    Priority: %d", SD_task_get_dax_priority(task));
+  if (cloud_description){
+    if (platform_file)
+      xbt_die("--platform and --cloud are mutually exclusive");
+    parse_cloud_spec(cloud_description, &cloud);
+    /* The pool has to fit all the configurations that will be run */
+    if (sweep_file){
+      configurations = read_sweep_configurations(sweep_file, globals);
+    } else {
+      configurations = xbt_dynar_new(sizeof(struct _scheduling_globals), NULL);
+      xbt_dynar_push(configurations, globals);
+    }
+    create_cloud_environment(&cloud, get_cloud_pool_size(&cloud, configurations));
+    xbt_dynar_free(&configurations);
+    platform_file = cloud_description;
+  } else if (platform_file){
+    SD_create_environment(platform_file);
+  } else {
+    xbt_die("A platform has to be given, either with --platform or --cloud");
   }
 
-  XBT_INFO("Scheduling constraints:");
-  /* Sanity checks about crucial parameters */
-  if (globals->budget && globals->deadline){
-    XBT_INFO("  Budget: $%.0f", globals->budget);
-    XBT_INFO("  Deadline: %.0fs", globals->deadline);
+  if (engine == ENGINE_NATIVE && globals->alg != DPDS && globals->alg != WADPDS)
+    xbt_die("The native engine only supports DPDS and WA-DPDS");
+  engine_init(engine, globals->locality);
+  /* SimDAG cannot delay a control dependency, only the native engine can account for the folded transfers */
+  if (network == NETWORK_LATENCY && engine != ENGINE_NATIVE)
+    xbt_die("--network=latency requires the native engine");
+  set_network_model(network);
+  total_nhosts = sg_host_count();
+  hosts = sg_host_list();
+
+  /* Sort the hosts by name for sake of simplicity */
+  qsort((void *)hosts,total_nhosts, sizeof(sg_host_t), nameCompareHosts);
+
+  sg_host_allocate_attributes(hosts, total_nhosts);
+
+  /* All the random numbers, e.g., to draw arrivals, priorities or VMs, come from streams derived from this seed */
+  rng_seed(globals->seed);
+
+  load_time = get_wall_time();
+  if (arrival_file || arrival_rate > 0){
+    /* Online mode: workflows arrive over time, from a trace or following a Poisson process until the deadline. In
+     * the latter case, the DAX files given on the command line are the workflows that may arrive. DAXes are loaded
+     * when they arrive, and parsed files are kept as templates until the end of the simulation.
+     */
+    arrivals_set_cache_dir(cache_dir);
+    if (!arrival_rate && !xbt_dynar_is_empty(dax_files))
+      xbt_die("--dax and --dax-repeat are only used by --poisson, the workflows of --arrivals are given by the trace");
+    if (arrival_file)
+      arrivals_read_trace(arrival_file);
+    if (arrival_rate > 0)
+      arrivals_generate_poisson(arrival_rate, globals->deadline, dax_files);
+    xbt_dynar_foreach(dax_names, cursor, daxname)
+      free(daxname);
   } else {
-    xbt_die("  A budget and a deadline have to be provided. Stop here");
-  }
-  printf("\n");
-  switch(globals->alg){
-  case DPDS:
-    dpds(daxes, globals);
-    break;
-  default:
-    XBT_ERROR("Algorithm not implemented yet.");
-    break;
-  }
-  printf("\n");
-
-  /* Post-processing of simulation */
-  /* Determine how many DAXes are complete */
-  xbt_dynar_foreach(daxes, cursor, current_dax){
-    task = get_end(current_dax);
-    if (SD_task_get_state(task) == SD_DONE){
-      completed_daxes++;
+    /* Load the DAXes, possibly from the cache of parsed DAXes. Each file is parsed only once. */
+    xbt_dynar_foreach(dax_files, cursor, daxfile){
+      xbt_dynar_get_cpy(dax_names, cursor, &daxname);
+      XBT_DEBUG("Loading %s", daxname);
+      current_dax = load_dax(daxfile, cache_dir, daxname);
+      ntasks += xbt_dynar_length(current_dax);
+      xbt_dynar_push(daxes,&current_dax);
+      free(daxname);
     }
+    free_dax_templates();
   }
+  load_time = get_wall_time() - load_time;
+  xbt_dynar_free(&dax_files);
+  xbt_dynar_free(&dax_names);
 
-  /* Terminate all VMs and do the final billing*/
-  for (cursor = 0; cursor < total_nhosts; cursor++){
-    attr = sg_host_user(hosts[cursor]);
-    if (attr->on_off)
-      sg_host_terminate(hosts[cursor]);
-    total_cost += attr->total_cost;
-  }
+  if (estimate_only){
+    /* Bounds of the results, computed without simulating */
+    if (get_number_of_arrivals())
+      xbt_die("--estimate cannot be used in online mode");
+    if (!globals->budget || !globals->deadline)
+      xbt_die("A budget and a deadline have to be provided. Stop here");
+    if (sweep_file){
+      run_estimate_sweep(daxes, globals, sweep_file);
+    } else {
+      assign_dax_priorities(daxes, globals->priority_method);
+      estimate_simulation(globals, &estimate);
+      XBT_INFO("Bounds of the simulation of %d DAXes with %s (not simulated):", get_number_of_daxes(),
+               getAlgorithmName(globals->alg));
+      XBT_INFO("  Makespan: at least %.3f seconds.", estimate.min_makespan);
+      XBT_INFO("  Success rate: at most %d/%d", estimate.max_completed_daxes, get_number_of_daxes());
+      XBT_INFO("  Total cost: at least $%.2f", estimate.min_cost);
+      XBT_INFO("  Score: at most %f", estimate.max_score);
+    }
+  } else if (sweep_file){
+    /* Each configuration of the sweep is simulated by a separate process */
+    if (dump_file)
+      XBT_WARN("--dump is ignored by parameter sweeps");
+    run_sweep(daxes, globals, sweep_file, jobs);
+  } else if (replications > 1){
+    /* Each replication is simulated by a separate process, with its own seed */
+    if (dump_file)
+      XBT_WARN("--dump is ignored by replications");
+    run_replications(daxes, globals, replications, jobs);
+  } else {
+    /* Display some information about the current run */
+    XBT_INFO("Algorithm: %s",getAlgorithmName(globals->alg));
+    XBT_INFO("  Priority method: %s", globals->priority_method ? "SORTED" : "RANDOM");
+    XBT_INFO("  Seed: %llu", globals->seed);
+    XBT_INFO("  Dynamic provisioning period: %.0fs", globals->period);
+    XBT_INFO("  Lower utilization threshold: %.2f%%", globals->ul);
+    XBT_INFO("  Upper utilization threshold: %.2f%%", globals->uh);
+    if (globals->fast_forward)
+      XBT_INFO("  Fast-forward through idle provisioning periods");
+
+    XBT_INFO("Platform: %s (%zu potential VMs)", platform_file, sg_host_count());
+    XBT_INFO("  VM hourly cost: $%f", globals->price);
+    XBT_INFO("  VM provisioning delay: %.0fs", globals->provisioning_delay);
+    if (dpds_initial_VMs(globals) > sg_host_count()){
+      xbt_die("The platform file doesn't have enough nodes. Stop here");
+    }
+
+    XBT_INFO("Ensemble: %lu DAXes", xbt_dynar_length(daxes));
+    if (get_number_of_arrivals())
+      XBT_INFO("  Online mode: %d workflows arrive during the simulation", get_number_of_arrivals());
+    /* Assign priorities to the DAXes composing the ensemble according to the chosen method: RANDOM (default) or
+     * SORTED. Then display the result.
+     */
+    assign_dax_priorities(daxes, globals->priority_method);
+    xbt_dynar_foreach(daxes, cursor, current_dax){
+       task = get_root(current_dax);
+       XBT_INFO("  %s", SD_task_get_dax_name(task));
+       XBT_INFO("    Priority: %d", SD_task_get_dax_priority(task));
+    }
+
+    XBT_INFO("Scheduling constraints:");
+    /* Sanity checks about crucial parameters */
+    if (globals->budget && globals->deadline){
+      XBT_INFO("  Budget: $%.0f", globals->budget);
+      XBT_INFO("  Deadline: %.0fs", globals->deadline);
+    } else {
+      xbt_die("  A budget and a deadline have to be provided. Stop here");
+    }
+    printf("\n");
+    if (explore_file){
+      /* Branches are forked during the simulation, each one sends its result back before the end of the program */
+      if (dump_file)
+        XBT_WARN("--dump is ignored by what-if explorations");
+      dump_file = NULL;
+      explore_read_variants(explore_file, globals, jobs);
+    }
+    if (dump_file)
+      trace_open(dump_file, dump_format);
+    /* In offline mode, the bounds of the results are computed before simulating and checked afterwards */
+    if (!explore_file && !get_number_of_arrivals())
+      estimate_simulation(globals, &estimate);
+    run_simulation(daxes, globals, &result);
+    /* A run that could not start all the VMs it asked for is not the configuration that was asked for */
+    if (get_number_of_failed_VM_starts()){
+      XBT_CRITICAL("The pool of VMs is exhausted: %d VMs could not be started. Use a larger platform or pool",
+                   get_number_of_failed_VM_starts());
+      if (explore_is_branch())
+        _exit(1);
+      exit(1);
+    }
+    if (explore_is_branch())
+      worker_pool_report(&result);
+    trace_close();
+    printf("\n");
 
-  /* Compute the score of the schedule */
-  score = compute_score(daxes);
-
-  /* Display main information about the schedule */
-  XBT_INFO("Makespan: %.3f seconds.", SD_get_clock());
-  XBT_INFO("Success rate: %d/%lu", completed_daxes, xbt_dynar_length(daxes));
-  XBT_INFO("Total cost: $%.2f", total_cost);
-  XBT_INFO("Score: %f", score);
-  XBT_INFO("Cost/Budget: %f", total_cost / globals->budget);
-  XBT_INFO("Makespan/Deadline: %f", SD_get_clock() / globals->deadline);
-
-  /* Cleaning step: Free all the allocated data structures */
-  xbt_dynar_foreach(daxes, cursor, current_dax){
-    xbt_dynar_foreach(current_dax, cursor2, task) {
-      SD_task_free_attribute(task);
-      free(SD_task_get_data(task));
-      SD_task_destroy(task);
+    if (explore_file){
+      explore_report(&result);
+    } else {
+      /* Display main information about the schedule */
+      /* An early aborted run does not drain the running tasks. Its makespan and cost are those at the time it stopped,
+       * which cannot be compared with those of a complete run.
+       */
+      if (result.aborted)
+        XBT_INFO("Makespan: aborted at %.3f seconds (early abort)", result.makespan);
+      else
+        XBT_INFO("Makespan: %.3f seconds.", result.makespan);
+      XBT_INFO("Success rate: %d/%d", result.completed_daxes, result.ndaxes);
+      if (result.aborted)
+        XBT_INFO("Total cost: aborted ($%.2f spent when the run stopped)", result.total_cost);
+      else
+        XBT_INFO("Total cost: $%.2f", result.total_cost);
+      XBT_INFO("Score: %f", result.score);
+      if (!result.aborted){
+        XBT_INFO("Cost/Budget: %f", result.total_cost / globals->budget);
+        XBT_INFO("Makespan/Deadline: %f", result.makespan / globals->deadline);
+      }
+      if (!get_number_of_arrivals() && !check_estimate(&estimate, &result))
+        status = 1;
+      if (get_number_of_arrivals() && !result.aborted){
+        XBT_INFO("Throughput: %.3f workflows/hour", result.makespan > 0 ?
+                 result.completed_daxes / (result.makespan / 3600.) : 0.);
+        XBT_INFO("Peak number of workflows in memory: %d", get_peak_number_of_live_daxes());
+      }
+
+      /* Display the performance of the simulator itself */
+      getrusage(RUSAGE_SELF, &usage);
+      XBT_INFO("Load time: %.3f seconds (%lu tasks)", load_time, ntasks);
+      XBT_INFO("Scheduling time: %.3f seconds (%lu events, %.3f us/event)", result.wall_time, result.nevents,
+               result.nevents ? 1e6 * result.wall_time / result.nevents : 0.);
+      XBT_INFO("Peak RSS: %ld KiB", usage.ru_maxrss);
+      STATS_REPORT();
     }
-    xbt_dynar_free_container(&current_dax);
   }
+
+  /* Cleaning step: Free all the allocated data structures. The tasks of the DAXes still in memory are released with
+   * their descriptors.
+   */
   xbt_dynar_free(&daxes);
+  free_dax_descriptors();
+  free_dax_templates();
+  free_arrivals();
   free(globals);
+  engine_exit();
 
-  for(cursor = 0; cursor < total_nhosts; cursor++)
-    sg_host_free_attribute(hosts[cursor]);
+  sg_host_free_attributes(hosts, total_nhosts);
 
   SD_exit();
 
-  return 0;
+  return status;
 }
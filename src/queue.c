@@ -0,0 +1,153 @@
+/*
+ * Copyright (c) Centre de Calcul de l'IN2P3 du CNRS
+ * Contributor(s) : Frédéric SUTER (2012-2016)
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the license (GNU LGPL) which comes with this package.
+ */
+#include "xbt.h"
+#include "queue.h"
+#include "task.h"
+#include "simgrid/simdag.h"
+
+XBT_LOG_NEW_DEFAULT_SUBCATEGORY(queue, EnsembleSched, "Logging specific to the ready queue");
+
+/*****************************************************************************/
+/*****************************************************************************/
+/**************            Creator and destructor               **************/
+/*****************************************************************************/
+/*****************************************************************************/
+
+ready_queue_t ready_queue_new(int capacity){
+  ready_queue_t queue = (ready_queue_t) calloc (1, sizeof(struct _ReadyQueue));
+
+  queue->capacity = capacity > 0 ? capacity : 16;
+  queue->tasks = (SD_task_t *) calloc (queue->capacity, sizeof(SD_task_t));
+  queue->size = 0;
+  queue->next_seq = 0;
+
+  return queue;
+}
+
+/* Free the queue. Tasks that are still in the queue are marked as not queued anymore. */
+void ready_queue_free(ready_queue_t *queue){
+  int i;
+
+  for (i = 0; i < (*queue)->size; i++)
+    ((TaskAttribute) SD_task_get_data((*queue)->tasks[i]))->queue_index = -1;
+
+  free((*queue)->tasks);
+  free(*queue);
+  *queue = NULL;
+}
+
+/*****************************************************************************/
+/*****************************************************************************/
+/**************                   Accessors                     **************/
+/*****************************************************************************/
+/*****************************************************************************/
+
+int ready_queue_length(ready_queue_t queue){
+  return queue->size;
+}
+
+int ready_queue_is_empty(ready_queue_t queue){
+  return (queue->size == 0);
+}
+
+/* Return the i-th element of the underlying array. Elements are NOT sorted, only the first one is guaranteed to be the
+ * task of highest priority. Only meant for display purposes.
+ */
+SD_task_t ready_queue_get(ready_queue_t queue, int i){
+  return queue->tasks[i];
+}
+
+/*****************************************************************************/
+/*****************************************************************************/
+/**************                Heap management                  **************/
+/*****************************************************************************/
+/*****************************************************************************/
+
+/* Determine whether the task at position i has to be popped before the task at position j. The primary key is the
+ * priority of the DAX the task belongs to (greatest value first, as with the sorted dynar that was used before). The
+ * secondary key is the insertion order, which makes the order of tasks that belong to the same DAX deterministic.
+ */
+static int precedes(ready_queue_t queue, int i, int j){
+  int p1 = SD_task_get_dax_priority(queue->tasks[i]);
+  int p2 = SD_task_get_dax_priority(queue->tasks[j]);
+
+  if (p1 != p2)
+    return (p1 > p2);
+  return (((TaskAttribute) SD_task_get_data(queue->tasks[i]))->queue_seq <
+          ((TaskAttribute) SD_task_get_data(queue->tasks[j]))->queue_seq);
+}
+
+/* Exchange two elements of the heap and update the position stored in their attributes */
+static void swap(ready_queue_t queue, int i, int j){
+  SD_task_t tmp = queue->tasks[i];
+
+  queue->tasks[i] = queue->tasks[j];
+  queue->tasks[j] = tmp;
+  ((TaskAttribute) SD_task_get_data(queue->tasks[i]))->queue_index = i;
+  ((TaskAttribute) SD_task_get_data(queue->tasks[j]))->queue_index = j;
+}
+
+static void sift_up(ready_queue_t queue, int i){
+  while (i > 0 && precedes(queue, i, (i-1)/2)){
+    swap(queue, i, (i-1)/2);
+    i = (i-1)/2;
+  }
+}
+
+static void sift_down(ready_queue_t queue, int i){
+  int child;
+
+  while ((child = 2*i+1) < queue->size){
+    if (child+1 < queue->size && precedes(queue, child+1, child))
+      child++;
+    if (!precedes(queue, child, i))
+      break;
+    swap(queue, i, child);
+    i = child;
+  }
+}
+
+/* Insert a task in the queue in O(log n). A task that is already in the queue is ignored, which can be determined in
+ * constant time thanks to the position stored in its attribute.
+ */
+void ready_queue_push(ready_queue_t queue, SD_task_t task){
+  TaskAttribute attr = (TaskAttribute) SD_task_get_data(task);
+
+  if (attr->queue_index >= 0){
+    XBT_DEBUG("%s already queued, ignore", SD_task_get_name(task));
+    return;
+  }
+
+  if (queue->size == queue->capacity){
+    queue->capacity *= 2;
+    queue->tasks = (SD_task_t *) realloc (queue->tasks, queue->capacity * sizeof(SD_task_t));
+  }
+
+  attr->queue_seq = queue->next_seq++;
+  attr->queue_index = queue->size;
+  queue->tasks[queue->size++] = task;
+  sift_up(queue, attr->queue_index);
+}
+
+/* Remove and return the task of highest priority in O(log n). Return NULL if the queue is empty. */
+SD_task_t ready_queue_pop(ready_queue_t queue){
+  SD_task_t task;
+
+  if (!queue->size)
+    return NULL;
+
+  task = queue->tasks[0];
+  queue->size--;
+  if (queue->size){
+    queue->tasks[0] = queue->tasks[queue->size];
+    ((TaskAttribute) SD_task_get_data(queue->tasks[0]))->queue_index = 0;
+    sift_down(queue, 0);
+  }
+  ((TaskAttribute) SD_task_get_data(task))->queue_index = -1;
+
+  return task;
+}
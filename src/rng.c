@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) Centre de Calcul de l'IN2P3 du CNRS
+ * Contributor(s) : Frédéric SUTER (2012-2016)
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the license (GNU LGPL) which comes with this package.
+ */
+#include "rng.h"
+
+/* Each stream is a xoshiro256** generator (Blackman and Vigna), whose state is initialized by SplitMix64 from the seed
+ * and the identifier of the stream. Seeds of replications are derived the same way, so that the streams of two
+ * replications, or of two components, do not overlap in practice.
+ */
+static uint64_t state[RNG_NSTREAMS][4];
+static int seeded = 0;
+
+static uint64_t splitmix64(uint64_t *x){
+  uint64_t z = (*x += 0x9E3779B97F4A7C15ULL);
+
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  return z ^ (z >> 31);
+}
+
+static inline uint64_t rotl(uint64_t x, int k){
+  return (x << k) | (x >> (64 - k));
+}
+
+void rng_seed(uint64_t seed){
+  int i, j;
+  uint64_t x;
+
+  for (i = 0; i < RNG_NSTREAMS; i++){
+    x = seed;
+    x = splitmix64(&x) ^ (0xD1B54A32D192ED03ULL * (i + 1));
+    for (j = 0; j < 4; j++)
+      state[i][j] = splitmix64(&x);
+  }
+  seeded = 1;
+}
+
+/* Seed of a replication. The first replication uses the seed itself, so that a run with a given seed is the first
+ * replication of the runs with the same seed.
+ */
+uint64_t rng_replication_seed(uint64_t seed, int replication){
+  uint64_t x = seed ^ (0xA0761D6478BD642FULL * replication);
+
+  return replication ? splitmix64(&x) : seed;
+}
+
+uint64_t rng_next(rng_stream_t stream){
+  uint64_t *s = state[stream];
+  uint64_t result, t;
+
+  if (!seeded)
+    rng_seed(0);
+
+  result = rotl(s[1] * 5, 7) * 9;
+  t = s[1] << 17;
+  s[2] ^= s[0];
+  s[3] ^= s[1];
+  s[1] ^= s[2];
+  s[0] ^= s[3];
+  s[2] ^= t;
+  s[3] = rotl(s[3], 45);
+
+  return result;
+}
+
+/* Uniform double in [0;1) */
+double rng_uniform(rng_stream_t stream){
+  return (rng_next(stream) >> 11) * 0x1.0p-53;
+}
+
+/* Uniform integer in [0;n) */
+unsigned long rng_uniform_int(rng_stream_t stream, unsigned long n){
+  return (unsigned long) (n * rng_uniform(stream));
+}
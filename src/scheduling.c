@@ -4,9 +4,15 @@
  * This program is free software; you can redistribute it and/or modify it
  * under the terms of the license (GNU LGPL) which comes with this package.
  */
+#include <stdio.h>
 #include <string.h>
+#include <time.h>
 #include "simgrid/simdag.h"
+#include "dax.h"
 #include "host.h"
+#include "billing.h"
+#include "arrival.h"
+#include "engine.h"
 #include "scheduling.h"
 #include "xbt.h"
 
@@ -71,26 +77,122 @@ void handle_resource_dependency(sg_host_t host, SD_task_t task){
   sg_host_set_last_scheduled_task(host, task);
 }
 
+/* Data locality: when a task is scheduled on the host that executes, or executed, the source of one of its input
+ * transfers, this transfer is not needed. The dependency on the transfer is replaced by a control dependency on its
+ * source (unless the source is already done), and the transfer is left unscheduled, so that SimGrid does not simulate
+ * it. Has to be called before the task is scheduled. The host of the source is given by host_of, e.g.,
+ * engine_task_get_host for a source that is already scheduled, or the plan of a static algorithm.
+ */
+void handle_local_transfers(sg_host_t host, SD_task_t task, sg_host_t (*host_of)(SD_task_t)){
+  unsigned int i;
+  xbt_dynar_t inputs = SD_task_get_parents(task), sources;
+  SD_task_t input, source;
+
+  xbt_dynar_foreach(inputs, i, input){
+    if (SD_task_get_kind(input) != SD_TASK_COMM_E2E)
+      continue;
+    source = NULL;
+    sources = SD_task_get_parents(input);
+    if (!xbt_dynar_is_empty(sources))
+      xbt_dynar_get_cpy(sources, 0, &source);
+    xbt_dynar_free_container(&sources);
+    if (!source || host_of(source) != host)
+      continue;
+
+    XBT_DEBUG("%s is local to %s", SD_task_get_name(input), sg_host_get_name(host));
+    SD_task_dependency_remove(input, task);
+    if (SD_task_get_state(source) != SD_DONE && !SD_task_dependency_exists(source, task))
+      SD_task_dependency_add("local", NULL, source, task);
+  }
+  xbt_dynar_free_container(&inputs);
+}
+
+/* Monotonic wall clock time in seconds, to measure the performance of the simulator itself */
+double get_wall_time(){
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+/* Number of times the scheduling algorithm got the control back from the simulation engine during the current run */
+static unsigned long nwakeups = 0;
+
+void count_wakeup(){
+  nwakeups++;
+}
+
+/* Whether the scheduling algorithm stopped the current run before draining the running tasks (early abort) */
+static int aborted = 0;
 
-/* Determine how much money has already been spent. Each host/VM has an attribute that sums the cost (#hours*price)
- * for each period in which the VM is on.
+void report_early_abort(){
+  aborted = 1;
+}
+
+/* Run the scheduling algorithm on an ensemble whose priorities are already assigned, then terminate all the running
+ * VMs and gather the main figures of the resulting schedule.
  */
-double compute_budget_consumption(){
-  double consumed_budget = 0.0;
-  int i=0;
-  HostAttribute attr;
-  const sg_host_t *hosts = sg_host_list ();
-  int nhosts = sg_host_count ();
-
-  for(i=0;i<nhosts;i++){
-    attr = sg_host_user(hosts[i]);
-    consumed_budget += attr->total_cost;
-    if (attr->on_off){
-      XBT_DEBUG("%s : Account for %d consumed hours", sg_host_get_name(hosts[i]),
-          (int)(SD_get_clock()-attr->start_time)/3600);
-      consumed_budget += (((int)(SD_get_clock()-attr->start_time)/3600))*attr->price;
+void run_simulation(xbt_dynar_t daxes, scheduling_globals_t globals, simulation_result_t result){
+  unsigned int i;
+  const sg_host_t *hosts = sg_host_list();
+  xbt_dynar_t running_VMs;
+  sg_host_t host;
+
+  /* Assign price and provisioning delay to host/VM (for the sake of simplicity) */
+  for(i=0; i < sg_host_count(); i++){
+    sg_host_set_price(hosts[i], globals->price);
+    sg_host_set_provisioning_delay(hosts[i], globals->provisioning_delay);
+  }
+
+  nwakeups = 0;
+  aborted = 0;
+  result->wall_time = get_wall_time();
+  switch(globals->alg){
+  case DPDS:
+  case WADPDS:
+    dpds(daxes, globals);
+    break;
+  case SPSS:
+    spss(daxes, globals);
+    break;
+  default:
+    XBT_ERROR("Algorithm not implemented yet.");
+    break;
+  }
+  result->wall_time = get_wall_time() - result->wall_time;
+
+  /* Post-processing of simulation */
+  /* Determine how many DAXes are complete, including those already released in online mode */
+  result->ndaxes = get_number_of_daxes() + get_number_of_pending_arrivals();
+  result->completed_daxes = 0;
+  result->nevents = nwakeups;
+  result->aborted = aborted;
+  for (i = 0; i < get_number_of_daxes(); i++){
+    if (dax_is_completed(i)){
+      result->completed_daxes++;
     }
+    result->nevents += get_dax_descriptor(i)->ncompleted_tasks;
   }
 
-  return consumed_budget;
+  /* Terminate all running VMs and do the final billing*/
+  running_VMs = get_running_VMs();
+  xbt_dynar_foreach(running_VMs, i, host)
+    sg_host_terminate(host);
+  xbt_dynar_free_container(&running_VMs);
+  result->total_cost = get_consumed_budget();
+
+  /* Compute the score of the schedule */
+  result->score = compute_score();
+  result->makespan = engine_get_clock();
+}
+
+/* Write the main figures of a run as tab-separated columns (makespan, completed DAXes, number of DAXes, cost, score).
+ * The makespan and cost of an early aborted run are not those of a complete run, and are written as "aborted".
+ */
+void print_simulation_result(simulation_result_t result){
+  if (result->aborted)
+    printf("aborted\t%d\t%d\taborted\t%f\n", result->completed_daxes, result->ndaxes, result->score);
+  else
+    printf("%.3f\t%d\t%d\t%.2f\t%f\n", result->makespan, result->completed_daxes, result->ndaxes, result->total_cost,
+           result->score);
 }
@@ -0,0 +1,527 @@
+/*
+ * Copyright (c) Centre de Calcul de l'IN2P3 du CNRS
+ * Contributor(s) : Frédéric SUTER (2012-2016)
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the license (GNU LGPL) which comes with this package.
+ *
+ * spss.c
+ * SimDAG implementation of the Static Provisioning, Static Scheduling
+ * Algorithm from
+ * Cost- and Deadline-Constrained Provisioning for Scientific Workflow
+ * Ensembles in IaaS Clouds by Maciej Malawski, Gideon Juve, Ewa Deelman and
+ * Jarek Nabrzyski published at SC'12.
+ */
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include "xbt.h"
+#include "simgrid/simdag.h"
+#include "dax.h"
+#include "host.h"
+#include "task.h"
+#include "trace.h"
+#include "stats.h"
+#include "arrival.h"
+#include "scheduling.h"
+
+XBT_LOG_NEW_DEFAULT_SUBCATEGORY(spss, EnsembleSched, "Logging specific to the SPSS algorithm");
+
+/* A VM of the plan. A VM is leased for whole hours from its start time and executes the tasks planned on it back to
+ * back, in the order in which they were planned.
+ */
+typedef struct _PlannedVM *PlannedVM;
+struct _PlannedVM {
+  sg_host_t host;
+  double start;         /* time at which the VM is started */
+  double ready_at;      /* time at which the last task planned on the VM ends */
+  int hours;            /* number of hours leased */
+  int heap_index;       /* position in the heap of VMs (see below) */
+  xbt_dynar_t tasks;    /* planned tasks, in execution order */
+  int remaining;        /* planned tasks that are not done yet */
+
+  /* State of the VM before the planning of the current DAX, restored if this DAX is rejected */
+  int stamp;
+  double saved_ready_at;
+  int saved_hours;
+};
+
+/* The plan: at most one VM per host of the platform. VMs are kept in a min-heap ordered by ready_at, so that the VM
+ * that can start a task the earliest is found in constant time and updated in logarithmic time.
+ */
+static struct _PlannedVM *vms = NULL;
+static int nvms = 0;
+static int max_vms = 0;
+static int *heap = NULL;
+static int leased_hours = 0;
+
+/* VMs modified while planning the current DAX */
+static int *touched = NULL;
+static int ntouched = 0;
+static int stamp = 0;
+
+/* Per-task scratch arrays, indexed by the position of the task in its DAX and reused from one DAX to the other */
+static double *eft = NULL;      /* earliest finish time */
+static double *sub_deadline = NULL;
+static double *finish = NULL;   /* planned finish time */
+static int *order = NULL;       /* compute tasks in topological order */
+static int *indegree = NULL;
+static int *assignment = NULL;  /* index of the VM the task is planned on */
+static int scratch_size = 0;
+
+/* VM each task is planned on, keyed by task (data locality only) */
+static xbt_dict_t VM_of_task = NULL;
+
+static double runtime_of(SD_task_t task, double speed){
+  return SD_task_get_amount(task) / speed;
+}
+
+/* Number of hours to lease a VM started at 'start' so that it is still up at 'end' */
+static int lease_hours(double start, double end){
+  return MAX(1, (int) ceil((end - start) / 3600. - 0.00001));
+}
+
+/*****************************************************************************/
+/*****************************************************************************/
+/*****************            Heap of planned VMs             ****************/
+/*****************************************************************************/
+/*****************************************************************************/
+static void heap_swap(int i, int j){
+  int tmp = heap[i];
+
+  heap[i] = heap[j];
+  heap[j] = tmp;
+  vms[heap[i]].heap_index = i;
+  vms[heap[j]].heap_index = j;
+}
+
+static void heap_sift_up(int i){
+  while (i > 0 && vms[heap[i]].ready_at < vms[heap[(i - 1) / 2]].ready_at){
+    heap_swap(i, (i - 1) / 2);
+    i = (i - 1) / 2;
+  }
+}
+
+static void heap_sift_down(int i){
+  int smallest;
+
+  while (1){
+    smallest = i;
+    if (2 * i + 1 < nvms && vms[heap[2 * i + 1]].ready_at < vms[heap[smallest]].ready_at)
+      smallest = 2 * i + 1;
+    if (2 * i + 2 < nvms && vms[heap[2 * i + 2]].ready_at < vms[heap[smallest]].ready_at)
+      smallest = 2 * i + 2;
+    if (smallest == i)
+      break;
+    heap_swap(i, smallest);
+    i = smallest;
+  }
+}
+
+static void heap_rebuild(){
+  int i;
+
+  for (i = 0; i < nvms; i++){
+    heap[i] = i;
+    vms[i].heap_index = i;
+  }
+  for (i = nvms / 2 - 1; i >= 0; i--)
+    heap_sift_down(i);
+}
+
+/*****************************************************************************/
+/*****************************************************************************/
+/*****************                  Planning                  ****************/
+/*****************************************************************************/
+/*****************************************************************************/
+static void spss_save_VM(int v){
+  if (vms[v].stamp == stamp)
+    return;
+  vms[v].stamp = stamp;
+  vms[v].saved_ready_at = vms[v].ready_at;
+  vms[v].saved_hours = vms[v].hours;
+  touched[ntouched++] = v;
+}
+
+/* Put the plan back in the state it was before the planning of the current DAX */
+static void spss_undo(int nvms_before, int hours_before){
+  int i;
+
+  for (i = 0; i < ntouched; i++){
+    if (touched[i] < nvms_before){
+      vms[touched[i]].ready_at = vms[touched[i]].saved_ready_at;
+      vms[touched[i]].hours = vms[touched[i]].saved_hours;
+    }
+  }
+  nvms = nvms_before;
+  leased_hours = hours_before;
+  heap_rebuild();
+}
+
+/* Number of extra hours to lease to run a task that can start at 'ready' and lasts 'runtime' on VM v, or -1 if the
+ * task would end after 'deadline'. Also gives the time at which the task would start.
+ */
+static int spss_extra_hours(int v, double ready, double runtime, double deadline, double *start){
+  *start = MAX(ready, vms[v].ready_at);
+  if (*start + runtime - deadline >= 0.00001)
+    return -1;
+  return lease_hours(vms[v].start, *start + runtime) - vms[v].hours;
+}
+
+/* Plan a task that can start at 'ready', lasts 'runtime' and has to end before 'deadline'. Three options are
+ * considered: the VM on which the last parent of the task ends ('preferred', if any), the VM that is available the
+ * earliest, which is the only other VM that may meet the deadline if any does, or a new VM started just in time.
+ * The cheapest option wins. In case of a tie, reusing a VM is preferred. Returns the index of the chosen VM, or -1 if
+ * the deadline cannot be met.
+ * Remark: Some other VM may have paid time left while these ones have to be extended. Looking for it would make the
+ * planning quadratic in the number of VMs, which is not worth it.
+ */
+static int spss_plan_task(double ready, double runtime, double deadline, double delay, int preferred){
+  int v = -1, hours, extra_hours = -1, new_hours = -1;
+  double start = 0, candidate_start, new_start = 0, begin = 0;
+
+  if (preferred >= 0)
+    if ((extra_hours = spss_extra_hours(preferred, ready, runtime, deadline, &start)) >= 0)
+      v = preferred;
+  if (nvms && heap[0] != preferred){
+    hours = spss_extra_hours(heap[0], ready, runtime, deadline, &candidate_start);
+    if (hours >= 0 && (extra_hours < 0 || hours < extra_hours)){
+      v = heap[0];
+      extra_hours = hours;
+      start = candidate_start;
+    }
+  }
+  if (nvms < max_vms){
+    /* Start the VM so that it has booted when the task is ready */
+    new_start = MAX(0, ready - delay);
+    begin = MAX(ready, new_start + delay);
+    if (begin + runtime - deadline < 0.00001)
+      new_hours = lease_hours(new_start, begin + runtime);
+  }
+
+  if (v >= 0 && (new_hours < 0 || extra_hours <= new_hours)){
+    spss_save_VM(v);
+    vms[v].ready_at = start + runtime;
+    vms[v].hours += extra_hours;
+    leased_hours += extra_hours;
+    heap_sift_down(vms[v].heap_index);
+  } else if (new_hours >= 0){
+    v = nvms++;
+    vms[v].start = new_start;
+    vms[v].ready_at = begin + runtime;
+    vms[v].hours = new_hours;
+    vms[v].stamp = stamp;
+    touched[ntouched++] = v;
+    leased_hours += new_hours;
+    heap[v] = v;
+    vms[v].heap_index = v;
+    heap_sift_up(v);
+  } else {
+    v = -1;
+  }
+  return v;
+}
+
+static void spss_grow_scratch(int n){
+  if (n <= scratch_size)
+    return;
+  scratch_size = n;
+  eft = xbt_realloc(eft, n * sizeof(double));
+  sub_deadline = xbt_realloc(sub_deadline, n * sizeof(double));
+  finish = xbt_realloc(finish, n * sizeof(double));
+  order = xbt_realloc(order, n * sizeof(int));
+  indegree = xbt_realloc(indegree, n * sizeof(int));
+  assignment = xbt_realloc(assignment, n * sizeof(int));
+}
+
+/* Try to add a DAX to the plan. Returns 1 if it is admitted, 0 if it cannot meet the deadline or makes the plan
+ * exceed the budget, in which case the plan is left unchanged.
+ */
+static int spss_plan_dax(xbt_dynar_t dax, scheduling_globals_t globals, double speed){
+  unsigned int i;
+  int j, k, n = 0, c, v, last_parent;
+  int nvms_before = nvms, hours_before = leased_hours;
+  double critical_path = 0., ready, lft, runtime;
+  SD_task_t t, *neighbors;
+
+  spss_grow_scratch(xbt_dynar_length(dax));
+
+  /* Topological order of the compute tasks (Kahn's algorithm on the compute-only graph) */
+  xbt_dynar_foreach(dax, i, t){
+    if (SD_task_get_kind(t) != SD_TASK_COMP_SEQ)
+      continue;
+    indegree[i] = SD_task_get_compute_parents_count(t);
+    if (!indegree[i])
+      order[n++] = i;
+  }
+  for (k = 0; k < n; k++){
+    t = xbt_dynar_get_as(dax, order[k], SD_task_t);
+    neighbors = SD_task_get_compute_children(t);
+    for (j = 0; j < SD_task_get_compute_children_count(t); j++){
+      c = SD_task_get_dax_index(neighbors[j]);
+      if (!--indegree[c])
+        order[n++] = c;
+    }
+  }
+
+  /* Forward pass: earliest finish time of each task, assuming unlimited resources */
+  for (k = 0; k < n; k++){
+    t = xbt_dynar_get_as(dax, order[k], SD_task_t);
+    ready = 0.;
+    neighbors = SD_task_get_compute_parents(t);
+    for (j = 0; j < SD_task_get_compute_parents_count(t); j++)
+      ready = MAX(ready, eft[SD_task_get_dax_index(neighbors[j])]);
+    eft[order[k]] = ready + runtime_of(t, speed);
+    critical_path = MAX(critical_path, eft[order[k]]);
+  }
+
+  XBT_DEBUG("%s: critical path of %.3fs, slack of %.3fs", SD_task_get_dax_name(get_root(dax)), critical_path,
+            globals->deadline - critical_path);
+  if (critical_path > globals->deadline){
+    XBT_VERB("%s: the critical path is longer than the deadline", SD_task_get_dax_name(get_root(dax)));
+    return 0;
+  }
+
+  /* Backward pass: latest finish time of each task, then deadline distribution. The slack of the critical path is
+   * spread in proportion of the earliest finish times, without exceeding the latest finish times.
+   */
+  for (k = n - 1; k >= 0; k--){
+    t = xbt_dynar_get_as(dax, order[k], SD_task_t);
+    lft = globals->deadline;
+    neighbors = SD_task_get_compute_children(t);
+    for (j = 0; j < SD_task_get_compute_children_count(t); j++){
+      c = SD_task_get_dax_index(neighbors[j]);
+      lft = MIN(lft, sub_deadline[c] - runtime_of(neighbors[j], speed));
+    }
+    sub_deadline[order[k]] = critical_path > 0 ? MIN(lft, eft[order[k]] * globals->deadline / critical_path) : lft;
+  }
+
+  /* Plan the tasks on the VMs in topological order */
+  stamp++;
+  ntouched = 0;
+  for (k = 0; k < n; k++){
+    t = xbt_dynar_get_as(dax, order[k], SD_task_t);
+    ready = 0.;
+    last_parent = -1;
+    neighbors = SD_task_get_compute_parents(t);
+    for (j = 0; j < SD_task_get_compute_parents_count(t); j++){
+      c = SD_task_get_dax_index(neighbors[j]);
+      if (last_parent < 0 || finish[c] > finish[last_parent])
+        last_parent = c;
+    }
+    if (last_parent >= 0)
+      ready = finish[last_parent];
+    runtime = runtime_of(t, speed);
+    v = spss_plan_task(ready, runtime, sub_deadline[order[k]], globals->provisioning_delay,
+                       last_parent >= 0 ? assignment[last_parent] : -1);
+    if (v < 0){
+      XBT_VERB("%s: %s cannot be planned before its deadline", SD_task_get_dax_name(t), SD_task_get_name(t));
+      spss_undo(nvms_before, hours_before);
+      return 0;
+    }
+    assignment[order[k]] = v;
+    finish[order[k]] = vms[v].ready_at;
+  }
+
+  if (leased_hours * globals->price > globals->budget){
+    XBT_VERB("%s: planning this DAX would cost $%.2f", SD_task_get_dax_name(get_root(dax)),
+             leased_hours * globals->price);
+    spss_undo(nvms_before, hours_before);
+    return 0;
+  }
+
+  /* The DAX is admitted: commit its tasks to the VMs */
+  for (k = 0; k < n; k++){
+    t = xbt_dynar_get_as(dax, order[k], SD_task_t);
+    v = assignment[order[k]];
+    if (!vms[v].tasks)
+      vms[v].tasks = xbt_dynar_new(sizeof(SD_task_t), NULL);
+    xbt_dynar_push(vms[v].tasks, &t);
+    vms[v].remaining++;
+  }
+  return 1;
+}
+
+/*****************************************************************************/
+/*****************************************************************************/
+/*****************                  Execution                 ****************/
+/*****************************************************************************/
+/*****************************************************************************/
+static int startCompareVMs(const void *v1, const void *v2){
+  double s1 = vms[*((int *)v1)].start;
+  double s2 = vms[*((int *)v2)].start;
+
+  return (s1 > s2) - (s1 < s2);
+}
+
+static int priorityCompareDaxes(const void *d1, const void *d2){
+  return SD_task_get_dax_priority(get_root(*((xbt_dynar_t *)d1))) -
+      SD_task_get_dax_priority(get_root(*((xbt_dynar_t *)d2)));
+}
+
+/* Let the simulation run, accounting for the time spent in SimGrid */
+static xbt_dynar_t spss_simulate(double how_long){
+  xbt_dynar_t changed;
+
+  STATS_START(STATS_SIMULATE);
+  changed = SD_simulate(how_long);
+  STATS_STOP(STATS_SIMULATE);
+  count_wakeup();
+
+  return changed;
+}
+
+/* Host a task is planned on. The tasks are scheduled VM by VM, and a parent may be scheduled after its children.
+ * Looking its host up in the plan rather than in the engine finds the transfers within a VM whatever this order.
+ */
+static sg_host_t spss_planned_host(SD_task_t task){
+  PlannedVM vm = xbt_dict_get_or_null_ext(VM_of_task, (const char *) &task, sizeof(SD_task_t));
+
+  return vm ? vm->host : NULL;
+}
+
+/* Start the VMs of the plan at their planned time and let SimGrid execute the tasks. A VM is terminated as soon as
+ * all the tasks planned on it are done. With data locality, the transfers between tasks planned on the same VM are
+ * skipped.
+ */
+static void spss_execute(scheduling_globals_t globals){
+  unsigned int i;
+  int k = 0, remaining = 0, v;
+  int *start_order = xbt_new(int, nvms);
+  xbt_dict_t VM_of_host = xbt_dict_new_homogeneous(NULL);
+  xbt_dynar_t changed;
+  SD_task_t t;
+  DaxDescriptor dax;
+  PlannedVM vm;
+
+  for (v = 0; v < nvms; v++){
+    start_order[v] = v;
+    remaining += vms[v].remaining;
+    xbt_dict_set(VM_of_host, sg_host_get_name(vms[v].host), &(vms[v]), NULL);
+  }
+  if (globals->locality){
+    VM_of_task = xbt_dict_new_homogeneous(NULL);
+    for (v = 0; v < nvms; v++)
+      xbt_dynar_foreach(vms[v].tasks, i, t)
+        xbt_dict_set_ext(VM_of_task, (const char *) &t, sizeof(SD_task_t), &(vms[v]), NULL);
+  }
+  qsort(start_order, nvms, sizeof(int), startCompareVMs);
+
+  while (remaining){
+    while (k < nvms && (vms[start_order[k]].start - SD_get_clock()) < 0.00001){
+      v = start_order[k++];
+      XBT_VERB("Start %s with %d tasks", sg_host_get_name(vms[v].host), vms[v].remaining);
+      sg_host_start(vms[v].host);
+      sg_host_set_to_busy(vms[v].host);
+      STATS_START(STATS_SCHEDULING);
+      xbt_dynar_foreach(vms[v].tasks, i, t){
+        XBT_VERB("Schedule %s (%s) on %s", SD_task_get_name(t), SD_task_get_dax_name(t),
+                 sg_host_get_name(vms[v].host));
+        if (globals->locality)
+          handle_local_transfers(vms[v].host, t, spss_planned_host);
+        SD_task_schedulel(t, 1, vms[v].host);
+        handle_resource_dependency(vms[v].host, t);
+      }
+      STATS_STOP(STATS_SCHEDULING);
+    }
+
+    changed = spss_simulate(k < nvms ? vms[start_order[k]].start - SD_get_clock() : -1);
+    if (k == nvms && xbt_dynar_is_empty(changed)){
+      XBT_WARN("%d planned tasks cannot be executed", remaining);
+      break;
+    }
+
+    STATS_START(STATS_COMPLETION);
+    STATS_RECORD(STATS_TASKS_PER_WAKEUP, xbt_dynar_length(changed));
+    xbt_dynar_foreach(changed, i, t){
+      if (!strncmp(SD_task_get_name(t), "Booting", 7) ||
+          SD_task_get_kind(t) != SD_TASK_COMP_SEQ || SD_task_get_state(t) != SD_DONE)
+        continue;
+
+      XBT_VERB("%s (from %s) has completed", SD_task_get_name(t), SD_task_get_dax_name(t));
+      trace_task(t);
+      remaining--;
+
+      dax = get_dax_descriptor(SD_task_get_dax_id(t));
+      dax->ncompleted_tasks++;
+      if (t == dax->end){
+        XBT_INFO("%s: Complete!", dax->name);
+        dax->completed = 1;
+      }
+
+      /* Release the VM as soon as it has nothing left to do */
+      vm = xbt_dict_get(VM_of_host, sg_host_get_name((SD_task_get_workstation_list(t))[0]));
+      if (!--vm->remaining){
+        XBT_VERB("Terminate %s", sg_host_get_name(vm->host));
+        sg_host_terminate(vm->host);
+      }
+    }
+    STATS_STOP(STATS_COMPLETION);
+  }
+
+  xbt_dict_free(&VM_of_host);
+  xbt_dict_free(&VM_of_task);
+  free(start_order);
+}
+
+void spss(xbt_dynar_t daxes, scheduling_globals_t globals){
+  unsigned int i;
+  int v, admitted = 0;
+  const sg_host_t *hosts = sg_host_list();
+  xbt_dynar_t *sorted, current_dax;
+  double speed = sg_host_speed(hosts[0]);
+
+  if (get_number_of_pending_arrivals())
+    XBT_WARN("SPSS plans the ensemble statically. The %d workflows arriving later are ignored",
+             get_number_of_pending_arrivals());
+
+  max_vms = sg_host_count();
+  vms = xbt_new0(struct _PlannedVM, max_vms);
+  heap = xbt_new(int, max_vms);
+  touched = xbt_new(int, max_vms);
+  for (v = 0; v < max_vms; v++)
+    vms[v].host = hosts[v];
+
+  /* DAXes are considered by decreasing importance, i.e., increasing priority value, as the score favors the DAXes of
+   * lowest priority value. A DAX is admitted only if all its tasks can be planned before the deadline within the
+   * remaining budget.
+   * Remark: Runtimes are estimated on the first host, the platform being homogeneous, and data transfers are ignored
+   * as in the paper.
+   */
+  sorted = xbt_new(xbt_dynar_t, xbt_dynar_length(daxes));
+  xbt_dynar_foreach(daxes, i, current_dax)
+    sorted[i] = current_dax;
+  qsort(sorted, xbt_dynar_length(daxes), sizeof(xbt_dynar_t), priorityCompareDaxes);
+
+  STATS_START(STATS_PROVISIONING);
+  for (i = 0; i < xbt_dynar_length(daxes); i++){
+    if (spss_plan_dax(sorted[i], globals, speed)){
+      XBT_VERB("%s is admitted", SD_task_get_dax_name(get_root(sorted[i])));
+      admitted++;
+    } else {
+      XBT_INFO("%s is rejected", SD_task_get_dax_name(get_root(sorted[i])));
+    }
+  }
+  STATS_STOP(STATS_PROVISIONING);
+  XBT_VERB("%d DAXes admitted on %d VMs for %d hours ($%.2f)", admitted, nvms, leased_hours,
+           leased_hours * globals->price);
+
+  spss_execute(globals);
+
+  /* Cleaning step once simulation is over */
+  for (v = 0; v < max_vms; v++)
+    xbt_dynar_free(&(vms[v].tasks));
+  free(sorted);
+  free(vms);
+  free(heap);
+  free(touched);
+  free(eft);
+  free(sub_deadline);
+  free(finish);
+  free(order);
+  free(indegree);
+  free(assignment);
+  vms = NULL;
+  heap = touched = order = indegree = assignment = NULL;
+  eft = sub_deadline = finish = NULL;
+  nvms = max_vms = leased_hours = ntouched = scratch_size = 0;
+}
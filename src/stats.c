@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) Centre de Calcul de l'IN2P3 du CNRS
+ * Contributor(s) : Frédéric SUTER (2012-2016)
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the license (GNU LGPL) which comes with this package.
+ */
+#include <stdio.h>
+#include "xbt.h"
+#include "simgrid/simdag.h"
+#include "scheduling.h"
+#include "stats.h"
+
+XBT_LOG_NEW_DEFAULT_SUBCATEGORY(stats, EnsembleSched, "Logging specific to the hot path instrumentation");
+
+typedef struct _PhaseStats {
+  unsigned long calls;
+  double total;
+  double max;
+  double started_at;
+} PhaseStats;
+
+typedef struct _Histogram {
+  unsigned long count;
+  unsigned long max;
+  double sum;
+  unsigned long buckets[STATS_NBUCKETS];
+} Histogram;
+
+static PhaseStats phases[STATS_NPHASES];
+static Histogram histograms[STATS_NHISTOGRAMS];
+
+static const char *phase_names[] = {"SD_simulate", "Completion", "Scheduling", "Provisioning"};
+static const char *histogram_names[] = {"Tasks per wake-up", "Queue length", "Idle VMs"};
+
+void stats_start(stats_phase_t phase){
+  phases[phase].started_at = get_wall_time();
+}
+
+void stats_stop(stats_phase_t phase){
+  double elapsed = get_wall_time() - phases[phase].started_at;
+
+  phases[phase].calls++;
+  phases[phase].total += elapsed;
+  if (elapsed > phases[phase].max)
+    phases[phase].max = elapsed;
+}
+
+void stats_record(stats_histogram_t histogram, unsigned long value){
+  Histogram *h = &(histograms[histogram]);
+  int bucket = 0;
+
+  while (value >> bucket && bucket < STATS_NBUCKETS - 1)
+    bucket++;
+  h->buckets[bucket]++;
+  h->count++;
+  h->sum += value;
+  if (value > h->max)
+    h->max = value;
+}
+
+/* Display a summary of all the phases and histograms */
+void stats_report(){
+  int i, j;
+  double total = 0.;
+  char line[1024];
+  int length;
+
+  for (i = 0; i < STATS_NPHASES; i++)
+    total += phases[i].total;
+
+  XBT_INFO("Hot path statistics:");
+  for (i = 0; i < STATS_NPHASES; i++)
+    XBT_INFO("  %-13s %10lu calls, %10.3f s (%5.1f%%), %10.3f us/call, max %10.3f us", phase_names[i],
+             phases[i].calls, phases[i].total, total > 0 ? 100. * phases[i].total / total : 0.,
+             phases[i].calls ? 1e6 * phases[i].total / phases[i].calls : 0., 1e6 * phases[i].max);
+
+  for (i = 0; i < STATS_NHISTOGRAMS; i++){
+    XBT_INFO("  %s: %lu samples, mean %.2f, max %lu", histogram_names[i], histograms[i].count,
+             histograms[i].count ? histograms[i].sum / histograms[i].count : 0., histograms[i].max);
+    length = 0;
+    for (j = 0; j < STATS_NBUCKETS && length < sizeof(line) - 64; j++){
+      if (!histograms[i].buckets[j])
+        continue;
+      if (j < 2)
+        length += snprintf(line + length, sizeof(line) - length, " [%d]:%lu", j, histograms[i].buckets[j]);
+      else
+        length += snprintf(line + length, sizeof(line) - length, " [%lu-%lu]:%lu", 1UL << (j - 1),
+                           (1UL << j) - 1, histograms[i].buckets[j]);
+    }
+    if (length)
+      XBT_INFO("   %s", line);
+  }
+}
@@ -0,0 +1,428 @@
+/*
+ * Copyright (c) Centre de Calcul de l'IN2P3 du CNRS
+ * Contributor(s) : Frédéric SUTER (2012-2016)
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the license (GNU LGPL) which comes with this package.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "xbt.h"
+#include "simgrid/simdag.h"
+#include "dax.h"
+#include "host.h"
+#include "scheduling.h"
+#include "sweep.h"
+#include "arrival.h"
+#include "rng.h"
+#include "estimate.h"
+
+XBT_LOG_NEW_DEFAULT_SUBCATEGORY(sweep, EnsembleSched, "Logging specific to parameter sweeps");
+
+/*****************************************************************************/
+/*****************************************************************************/
+/**************                  Worker pool                    **************/
+/*****************************************************************************/
+/*****************************************************************************/
+
+/* SimGrid is not thread-safe, and its state cannot be reset once a simulation has run. Independent simulations are
+ * thus run in forked processes. The parent process never runs a simulation itself, so that each worker starts from the
+ * same state.
+ */
+
+/* Write end of the pipe to the parent, only meaningful in a worker */
+static int report_fd = -1;
+
+int get_number_of_cores(){
+  long ncores = sysconf(_SC_NPROCESSORS_ONLN);
+
+  return ncores > 0 ? (int) ncores : 1;
+}
+
+worker_pool_t worker_pool_new(int max_workers){
+  worker_pool_t pool = (worker_pool_t) calloc (1, sizeof(struct _worker_pool));
+
+  pool->max_workers = max_workers > 0 ? max_workers : get_number_of_cores();
+  pool->nworkers = 0;
+  pool->pids = (pid_t *) calloc (pool->max_workers, sizeof(pid_t));
+  pool->pipes = (int *) calloc (pool->max_workers, sizeof(int));
+  pool->jobs = (int *) calloc (pool->max_workers, sizeof(int));
+
+  return pool;
+}
+
+void worker_pool_free(worker_pool_t *pool){
+  free((*pool)->pids);
+  free((*pool)->pipes);
+  free((*pool)->jobs);
+  free(*pool);
+  *pool = NULL;
+}
+
+int worker_pool_is_full(worker_pool_t pool){
+  return (pool->nworkers == pool->max_workers);
+}
+
+int worker_pool_is_empty(worker_pool_t pool){
+  return (pool->nworkers == 0);
+}
+
+/* Fork a new worker to run a job. The pool must not be full. Like fork, return 0 in the worker and a positive value in
+ * the parent.
+ */
+int worker_pool_fork(worker_pool_t pool, int job){
+  int fd[2];
+  pid_t pid;
+
+  xbt_assert(!worker_pool_is_full(pool), "Cannot fork more than %d workers", pool->max_workers);
+
+  fflush(stdout);
+  fflush(stderr);
+  if (pipe(fd))
+    xbt_die("Cannot create a pipe for job %d", job);
+
+  pid = fork();
+  if (pid < 0)
+    xbt_die("Cannot fork a worker for job %d", job);
+
+  if (pid == 0){
+    close(fd[0]);
+    report_fd = fd[1];
+    return 0;
+  }
+
+  close(fd[1]);
+  pool->pids[pool->nworkers] = pid;
+  pool->pipes[pool->nworkers] = fd[0];
+  pool->jobs[pool->nworkers] = job;
+  pool->nworkers++;
+
+  return (int) pid;
+}
+
+/* Send the result of a worker to the parent process and terminate the worker. Nothing is cleaned as the process ends
+ * right away.
+ */
+void worker_pool_report(simulation_result_t result){
+  int status = 0;
+
+  if (write(report_fd, result, sizeof(struct _simulation_result)) != sizeof(struct _simulation_result))
+    status = 1;
+  close(report_fd);
+  fflush(stdout);
+  fflush(stderr);
+  _exit(status);
+}
+
+/* Wait for the completion of any worker of the pool. The identifier of its job is stored in job. Return 1 if the worker
+ * sent a result and 0 if it failed (e.g., the simulation aborted).
+ */
+int worker_pool_wait(worker_pool_t pool, int *job, simulation_result_t result){
+  int i, status, success;
+  pid_t pid;
+
+  xbt_assert(!worker_pool_is_empty(pool), "No worker to wait for");
+
+  do {
+    pid = waitpid(-1, &status, 0);
+    for (i = 0; i < pool->nworkers && pool->pids[i] != pid; i++);
+  } while (i == pool->nworkers);
+
+  /* The result is small enough to have been entirely written in the pipe before the worker ended */
+  success = WIFEXITED(status) && !WEXITSTATUS(status) &&
+      read(pool->pipes[i], result, sizeof(struct _simulation_result)) == sizeof(struct _simulation_result);
+  close(pool->pipes[i]);
+  *job = pool->jobs[i];
+
+  /* Move the last worker at the position of the one that just ended */
+  pool->nworkers--;
+  pool->pids[i] = pool->pids[pool->nworkers];
+  pool->pipes[i] = pool->pipes[pool->nworkers];
+  pool->jobs[i] = pool->jobs[pool->nworkers];
+
+  return success;
+}
+
+/*****************************************************************************/
+/*****************************************************************************/
+/**************              Parameter sweep driver             **************/
+/*****************************************************************************/
+/*****************************************************************************/
+
+/* Read the configurations of a sweep. Each non empty line of the file (apart from comments starting by '#') describes a
+ * configuration as a list of key=value pairs separated by blanks, e.g.,
+ *   budget=100 deadline=36000 priority=sorted period=90 uh=90 ul=70 provisioning_delay=0 price=1 seed=42
+ * Parameters that are not set keep the value given on the command line.
+ */
+xbt_dynar_t read_sweep_configurations(const char *filename, scheduling_globals_t base){
+  char line[4096], *token, *value, *saveptr;
+  int line_number = 0;
+  struct _scheduling_globals config;
+  xbt_dynar_t configurations = xbt_dynar_new(sizeof(struct _scheduling_globals), NULL);
+  FILE *f = fopen(filename, "r");
+
+  if (!f)
+    xbt_die("Cannot open the sweep file %s", filename);
+
+  while (fgets(line, sizeof(line), f)){
+    line_number++;
+    if ((token = strchr(line, '#')))
+      *token = '\0';
+    config = *base;
+    token = strtok_r(line, " \t\r\n", &saveptr);
+    if (!token)
+      continue;
+    for (; token; token = strtok_r(NULL, " \t\r\n", &saveptr)){
+      value = strchr(token, '=');
+      if (!value)
+        xbt_die("%s:%d: '%s' is not a key=value pair", filename, line_number, token);
+      *value++ = '\0';
+      if (!strcmp(token, "budget"))
+        config.budget = atof(value);
+      else if (!strcmp(token, "deadline"))
+        config.deadline = atof(value);
+      else if (!strcmp(token, "price"))
+        config.price = atof(value);
+      else if (!strcmp(token, "period"))
+        config.period = atof(value);
+      else if (!strcmp(token, "uh"))
+        config.uh = atof(value);
+      else if (!strcmp(token, "ul"))
+        config.ul = atof(value);
+      else if (!strcmp(token, "provisioning_delay"))
+        config.provisioning_delay = atof(value);
+      else if (!strcmp(token, "seed"))
+        config.seed = strtoull(value, NULL, 10);
+      else if (!strcmp(token, "priority") && !strcmp(value, "random"))
+        config.priority_method = RANDOM;
+      else if (!strcmp(token, "priority") && !strcmp(value, "sorted"))
+        config.priority_method = SORTED;
+      else
+        xbt_die("%s:%d: unknown parameter or value '%s=%s'", filename, line_number, token, value);
+    }
+    xbt_dynar_push(configurations, &config);
+  }
+  fclose(f);
+
+  return configurations;
+}
+
+/* Body of a worker: check the configuration, run the simulation and report its result */
+static void run_sweep_configuration(xbt_dynar_t daxes, scheduling_globals_t config){
+  struct _simulation_result result;
+
+  if (!config->budget || !config->deadline){
+    XBT_ERROR("A budget and a deadline have to be provided.");
+    _exit(1);
+  }
+  if (dpds_initial_VMs(config) > sg_host_count()){
+    XBT_ERROR("The platform file doesn't have enough nodes for budget=%.0f and deadline=%.0f",
+              config->budget, config->deadline);
+    _exit(1);
+  }
+
+  /* Keep the output of the workers quiet, only the table of results matters */
+  xbt_log_control_set("root.thresh:critical");
+
+  rng_seed(config->seed);
+  arrivals_redraw();
+  assign_dax_priorities(daxes, config->priority_method);
+  run_simulation(daxes, config, &result);
+
+  /* A run that could not start all the VMs it asked for is not the configuration that was asked for */
+  if (get_number_of_failed_VM_starts()){
+    XBT_CRITICAL("The pool of VMs is exhausted for budget=%.0f and deadline=%.0f (%d VMs could not be started)",
+                 config->budget, config->deadline, get_number_of_failed_VM_starts());
+    _exit(1);
+  }
+  worker_pool_report(&result);
+}
+
+/* Run a simulation for each configuration of a sweep file, with at most max_workers simulations at a time, and display
+ * a table of results, one line per configuration in the order of the file.
+ */
+void run_sweep(xbt_dynar_t daxes, scheduling_globals_t globals, const char *filename, int max_workers){
+  unsigned int i;
+  int job;
+  struct _simulation_result result;
+  xbt_dynar_t configurations = read_sweep_configurations(filename, globals);
+  int nconfigurations = xbt_dynar_length(configurations);
+  struct _simulation_result *results = calloc (nconfigurations, sizeof(struct _simulation_result));
+  int *success = calloc (nconfigurations, sizeof(int));
+  worker_pool_t pool = worker_pool_new(max_workers);
+  scheduling_globals_t config;
+
+  XBT_INFO("Sweep: %d configurations from %s on %d workers", nconfigurations, filename, pool->max_workers);
+
+  for (i = 0; i < nconfigurations; i++){
+    while (worker_pool_is_full(pool)){
+      if (worker_pool_wait(pool, &job, &result)){
+        results[job] = result;
+        success[job] = 1;
+      }
+    }
+    config = (scheduling_globals_t) xbt_dynar_get_ptr(configurations, i);
+    if (!worker_pool_fork(pool, i))
+      run_sweep_configuration(daxes, config);
+  }
+  while (!worker_pool_is_empty(pool)){
+    if (worker_pool_wait(pool, &job, &result)){
+      results[job] = result;
+      success[job] = 1;
+    }
+  }
+
+  printf("#config\tbudget\tdeadline\tpriority\tperiod\tuh\tul\tprovisioning_delay\tprice\tseed\t"
+         "makespan\tcompleted\tdaxes\tcost\tscore\n");
+  for (i = 0; i < nconfigurations; i++){
+    config = (scheduling_globals_t) xbt_dynar_get_ptr(configurations, i);
+    printf("%u\t%g\t%g\t%s\t%g\t%g\t%g\t%g\t%g\t%llu\t", i, config->budget, config->deadline,
+           config->priority_method ? "sorted" : "random", config->period, config->uh, config->ul,
+           config->provisioning_delay, config->price, config->seed);
+    if (success[i])
+      print_simulation_result(&(results[i]));
+    else
+      printf("failed\tfailed\tfailed\tfailed\tfailed\n");
+  }
+
+  worker_pool_free(&pool);
+  free(success);
+  free(results);
+  xbt_dynar_free(&configurations);
+}
+
+/* Estimate the bounds of each configuration of a sweep file without simulating (see estimate.h), and display them as
+ * a table in the order of the file. Configurations whose bounds are hopeless or trivial can then be skipped before
+ * running the actual sweep. This is cheap enough to be done in the parent process.
+ */
+void run_estimate_sweep(xbt_dynar_t daxes, scheduling_globals_t globals, const char *filename){
+  unsigned int i;
+  struct _estimate estimate;
+  xbt_dynar_t configurations = read_sweep_configurations(filename, globals);
+  scheduling_globals_t config;
+
+  XBT_INFO("Sweep: bounds of %lu configurations from %s", xbt_dynar_length(configurations), filename);
+
+  printf("#config\tbudget\tdeadline\tpriority\tperiod\tuh\tul\tprovisioning_delay\tprice\tseed\t"
+         "min_makespan\tmax_completed\tdaxes\tmin_cost\tmax_score\n");
+  for (i = 0; i < xbt_dynar_length(configurations); i++){
+    config = (scheduling_globals_t) xbt_dynar_get_ptr(configurations, i);
+    rng_seed(config->seed);
+    assign_dax_priorities(daxes, config->priority_method);
+    estimate_simulation(config, &estimate);
+    printf("%u\t%g\t%g\t%s\t%g\t%g\t%g\t%g\t%g\t%llu\t", i, config->budget, config->deadline,
+           config->priority_method ? "sorted" : "random", config->period, config->uh, config->ul,
+           config->provisioning_delay, config->price, config->seed);
+    printf("%.3f\t%d\t%d\t%.2f\t%f\n", estimate.min_makespan, estimate.max_completed_daxes, get_number_of_daxes(),
+           estimate.min_cost, estimate.max_score);
+  }
+
+  xbt_dynar_free(&configurations);
+}
+
+/*****************************************************************************/
+/*****************************************************************************/
+/**************             Monte-Carlo replications            **************/
+/*****************************************************************************/
+/*****************************************************************************/
+
+/* Quantiles of the Student's t-distribution for two-sided 95% confidence intervals, for 1 to 30 degrees of freedom.
+ * The normal approximation is used beyond.
+ */
+static const double student_t_95[] = {
+  12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+  2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+  2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+};
+
+/* Display the mean, standard deviation and 95% confidence interval of n values */
+static void print_summary(const char *name, const double *values, int n){
+  int i;
+  double mean = 0., variance = 0., half_width = 0.;
+
+  for (i = 0; i < n; i++)
+    mean += values[i];
+  mean /= n;
+  for (i = 0; i < n; i++)
+    variance += (values[i] - mean) * (values[i] - mean);
+  if (n > 1){
+    variance /= n - 1;
+    half_width = (n - 1 <= 30 ? student_t_95[n - 2] : 1.96) * sqrt(variance / n);
+  }
+  printf("# %s: mean %f, stddev %f, 95%% CI [%f, %f]\n", name, mean, sqrt(variance), mean - half_width,
+         mean + half_width);
+}
+
+/* Run n replications of the same configuration, each with its own seed derived from the seed of the configuration.
+ * A replication can be run again on its own by giving its seed to --seed.
+ */
+void run_replications(xbt_dynar_t daxes, scheduling_globals_t globals, int n, int max_workers){
+  int i, job, nsuccesses = 0, ncomplete = 0;
+  struct _simulation_result result;
+  struct _scheduling_globals *configs = calloc (n, sizeof(struct _scheduling_globals));
+  struct _simulation_result *results = calloc (n, sizeof(struct _simulation_result));
+  int *success = calloc (n, sizeof(int));
+  double *makespans, *costs, *scores;
+  worker_pool_t pool = worker_pool_new(max_workers);
+
+  XBT_INFO("Replications: %d runs from seed %llu on %d workers", n, globals->seed, pool->max_workers);
+
+  for (i = 0; i < n; i++){
+    configs[i] = *globals;
+    configs[i].seed = rng_replication_seed(globals->seed, i);
+    while (worker_pool_is_full(pool)){
+      if (worker_pool_wait(pool, &job, &result)){
+        results[job] = result;
+        success[job] = 1;
+      }
+    }
+    if (!worker_pool_fork(pool, i))
+      run_sweep_configuration(daxes, &(configs[i]));
+  }
+  while (!worker_pool_is_empty(pool)){
+    if (worker_pool_wait(pool, &job, &result)){
+      results[job] = result;
+      success[job] = 1;
+    }
+  }
+
+  makespans = calloc (n, sizeof(double));
+  costs = calloc (n, sizeof(double));
+  scores = calloc (n, sizeof(double));
+  printf("#replication\tseed\tmakespan\tcompleted\tdaxes\tcost\tscore\n");
+  for (i = 0; i < n; i++){
+    printf("%d\t%llu\t", i, configs[i].seed);
+    if (success[i]){
+      print_simulation_result(&(results[i]));
+      if (!results[i].aborted){
+        makespans[ncomplete] = results[i].makespan;
+        costs[ncomplete] = results[i].total_cost;
+        ncomplete++;
+      }
+      scores[nsuccesses] = results[i].score;
+      nsuccesses++;
+    } else {
+      printf("failed\tfailed\tfailed\tfailed\tfailed\n");
+    }
+  }
+  if (nsuccesses){
+    printf("# %d/%d replications succeeded\n", nsuccesses, n);
+    print_summary("score", scores, nsuccesses);
+  }
+  /* The makespan and cost of the replications that stopped early (--early-abort) cannot be compared */
+  if (ncomplete){
+    print_summary("cost", costs, ncomplete);
+    print_summary("makespan", makespans, ncomplete);
+  }
+
+  worker_pool_free(&pool);
+  free(makespans);
+  free(costs);
+  free(scores);
+  free(success);
+  free(results);
+  free(configs);
+}
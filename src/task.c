@@ -6,8 +6,10 @@
  */
 
 #include "xbt.h"
-#include "task.h"
 #include "simgrid/simdag.h"
+#include "dax.h"
+#include "task.h"
+#include "engine.h"
 
 XBT_LOG_NEW_DEFAULT_SUBCATEGORY(task, EnsembleSched, "Logging specific to tasks");
 
@@ -17,39 +19,74 @@ XBT_LOG_NEW_DEFAULT_SUBCATEGORY(task, EnsembleSched, "Logging specific to tasks"
 /*****************************************************************************/
 /*****************************************************************************/
 
-void SD_task_allocate_attribute(SD_task_t task){
-  void *data;
-  data = calloc(1,sizeof(struct _TaskAttribute));
-  SD_task_set_data(task, data);
+/* The attributes of all the tasks of a DAX are allocated at once, as a single slab in which they are stored in the
+ * order of the tasks in the DAX. The slab thus starts with the attribute of the root task, and is released at once.
+ */
+void SD_task_allocate_attributes(xbt_dynar_t dax){
+  unsigned int i;
+  SD_task_t task;
+  TaskAttribute slab = (TaskAttribute) calloc (xbt_dynar_length(dax), sizeof(struct _TaskAttribute));
+
+  xbt_dynar_foreach(dax, i, task){
+    slab[i].dax_index = i;
+    /* The task is not in the ready queue yet */
+    slab[i].queue_index = -1;
+    SD_task_set_data(task, &(slab[i]));
+  }
+}
+
+/* Release the attributes of all the tasks of a DAX. The tasks must not be used afterwards apart from being destroyed */
+void SD_task_free_attributes(xbt_dynar_t dax){
+  free(SD_task_get_data(get_root(dax)));
 }
 
-void SD_task_free_attribute(SD_task_t task){
+int SD_task_get_dax_id(SD_task_t task){
   TaskAttribute attr = (TaskAttribute) SD_task_get_data(task);
-  free(attr->daxname);
-  free(SD_task_get_data(task));
-  SD_task_set_data(task, NULL);
+  return attr->dax_id;
 }
-void SD_task_set_dax_name(SD_task_t task, char *daxname){
-  TaskAttribute attr = (TaskAttribute) SD_task_get_data(task);
-  attr->daxname=strdup(daxname);
-  SD_task_set_data(task, attr);
 
+int SD_task_get_dax_index(SD_task_t task){
+  TaskAttribute attr = (TaskAttribute) SD_task_get_data(task);
+  return attr->dax_index;
 }
 
+/* The name and priority of the DAX a task belongs to are stored once in the descriptor of this DAX */
 char* SD_task_get_dax_name(SD_task_t task){
+  return get_dax_descriptor(SD_task_get_dax_id(task))->name;
+}
+
+int SD_task_get_dax_priority(SD_task_t task){
+  return get_dax_descriptor(SD_task_get_dax_id(task))->priority;
+}
+
+int SD_task_is_queued(SD_task_t task){
   TaskAttribute attr = (TaskAttribute) SD_task_get_data(task);
-  return attr->daxname;
+  return (attr->queue_index >= 0);
 }
 
-void SD_task_set_dax_priority(SD_task_t task, int priority){
+int SD_task_get_compute_children_count(SD_task_t task){
   TaskAttribute attr = (TaskAttribute) SD_task_get_data(task);
-  attr->dax_priority=priority;
-  SD_task_set_data(task, attr);
+  return attr->nchildren;
 }
 
-int SD_task_get_dax_priority(SD_task_t task){
+SD_task_t *SD_task_get_compute_children(SD_task_t task){
+  TaskAttribute attr = (TaskAttribute) SD_task_get_data(task);
+  return attr->children;
+}
+
+int SD_task_get_compute_parents_count(SD_task_t task){
+  TaskAttribute attr = (TaskAttribute) SD_task_get_data(task);
+  return attr->nparents;
+}
+
+SD_task_t *SD_task_get_compute_parents(SD_task_t task){
+  TaskAttribute attr = (TaskAttribute) SD_task_get_data(task);
+  return attr->parents;
+}
+
+double SD_task_get_path_to_end(SD_task_t task){
   TaskAttribute attr = (TaskAttribute) SD_task_get_data(task);
-  return attr->dax_priority;
+  return attr->path_to_end;
 }
 
 /*****************************************************************************/
@@ -73,97 +110,30 @@ int daxPriorityCompareTasks(const void * t1, const void *t2){
     return 1;
 }
 
-/* Determine if a task is ready. The condition to meet is that all its compute predecessors have to be in one of the
- * following state:
+/* Determine if a task is ready. The condition to meet is that all its compute predecessors have been scheduled, i.e.,
+ * are in one of the following state:
+ *  - SD_SCHEDULED
  *  - SD_RUNNABLE
  *  - SD_RUNNING
  *  - SD_DONE
+ * and that the task itself is not scheduled yet. The number of compute predecessors that are not scheduled yet is
+ * maintained in the attribute of the task by SD_task_release_children, which makes this test constant time.
  */
 int SD_task_is_ready(SD_task_t task){
-  unsigned int i;
-  int is_ready = 1;
-  xbt_dynar_t parents, grand_parents;
-  SD_task_t parent, grand_parent;
-
-  parents = SD_task_get_parents(task);
-
-  if (xbt_dynar_length(parents)) {
-    xbt_dynar_foreach(parents, i, parent){
-      if (SD_task_get_kind(parent) == SD_TASK_COMM_E2E) {
-        /* Data dependency case: a compute task is preceded by a data transfer. Its parent (in a scheduling sense) is
-         * then the grand parent
-         */
-        grand_parents = SD_task_get_parents(parent);
-        xbt_dynar_get_cpy(grand_parents, 0, &grand_parent);
-        if (SD_task_get_state(grand_parent) < SD_SCHEDULED) {
-          is_ready =0;
-          xbt_dynar_free_container(&grand_parents); /* avoid memory leaks */
-          break;
-        } else {
-          xbt_dynar_free_container(&grand_parents); /* avoid memory leaks */
-        }
-      } else {
-        /* Control dependency case: a compute task predecessor is another compute task. */
-        if (SD_task_get_state(parent) < SD_SCHEDULED) {
-         is_ready =0;
-         break;
-        }
-      }
-    }
-  }
-  xbt_dynar_free_container(&parents); /* avoid memory leaks */
+  TaskAttribute attr = (TaskAttribute) SD_task_get_data(task);
 
-  return is_ready;
+  return (!attr->pending_parents && (engine_task_get_state(task) == SD_NOT_SCHEDULED ||
+          engine_task_get_state(task) == SD_SCHEDULABLE));
 }
 
-/* Build the set of the compute successors of a task that are ready (i.e., with all parents already scheduled). Both
- * data and control dependencies are checked. As more than one transfer may exist between two compute tasks, it is
- * mandatory to check whether the successor is not already in the set.
+/* Has to be called when a compute task is scheduled. Both data and control dependencies are already folded in the
+ * compute-only graph built when the DAX is loaded, and each compute successor appears only once in it. Then each
+ * successor has one less compute predecessor to wait for.
  */
-xbt_dynar_t SD_task_get_ready_children(SD_task_t t){
-  unsigned int i;
-  xbt_dynar_t children=NULL, ready_children;
-  xbt_dynar_t output_transfers = SD_task_get_children(t);
-  SD_task_t output, child;
-
-  ready_children = xbt_dynar_new(sizeof(SD_task_t), NULL);
-
-  xbt_dynar_foreach(output_transfers, i, output){
-    if (SD_task_get_kind(output) == SD_TASK_COMM_E2E) {
-      /* Data dependency case: a compute task is followed by a data transfer. Its child (in a scheduling sense) is
-       * then the grand child
-       */
-      children = SD_task_get_children(output);
-      xbt_dynar_get_cpy(children, 0, &child);
-
-      /* check if this child is already in the set */
-      if (xbt_dynar_member(ready_children, &child)){
-        XBT_DEBUG("%s already seen, ignore", SD_task_get_name(child));
-        xbt_dynar_free_container(&children); /* avoid memory leaks */
-        continue;
-      }
-
-      if (SD_task_get_kind(child) == SD_TASK_COMP_SEQ && (SD_task_get_state(child) == SD_NOT_SCHEDULED ||
-           SD_task_get_state(child) == SD_SCHEDULABLE) && SD_task_is_ready(child)){
-        xbt_dynar_push(ready_children, &child);
-      }
-      xbt_dynar_free_container(&children); /* avoid memory leaks */
-    } else {
-      /* Control dependency case: a compute task successor is another compute task. */
-      /* check if this child is already in the set */
-      if (xbt_dynar_member(ready_children, &output)){
-        XBT_DEBUG("%s already seen, ignore", SD_task_get_name(output));
-        continue;
-      }
-      if (SD_task_get_kind(output) == SD_TASK_COMP_SEQ && (SD_task_get_state(output) == SD_NOT_SCHEDULED ||
-           SD_task_get_state(output) == SD_SCHEDULABLE)&& SD_task_is_ready(output)){
-        xbt_dynar_push(ready_children, &output);
-      }
-    }
-  }
-
-  xbt_dynar_free_container(&output_transfers); /* avoid memory leaks */
+void SD_task_release_children(SD_task_t task){
+  int i;
+  TaskAttribute attr = (TaskAttribute) SD_task_get_data(task);
 
-  return ready_children;
+  for (i = 0; i < attr->nchildren; i++)
+    ((TaskAttribute) SD_task_get_data(attr->children[i]))->pending_parents--;
 }
-
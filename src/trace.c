@@ -0,0 +1,161 @@
+/*
+ * Copyright (c) Centre de Calcul de l'IN2P3 du CNRS
+ * Contributor(s) : Frédéric SUTER (2012-2016)
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the license (GNU LGPL) which comes with this package.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "xbt.h"
+#include "simgrid/simdag.h"
+#include "dax.h"
+#include "task.h"
+#include "host.h"
+#include "trace.h"
+#include "engine.h"
+
+XBT_LOG_NEW_DEFAULT_SUBCATEGORY(trace, EnsembleSched, "Logging specific to the schedule trace");
+
+/* Schedule trace produced by --dump. Events are formatted into a large in-memory buffer that is written to the file
+ * only when full, so that tracing does not slow the simulation down. When no trace is open, each event function
+ * returns right away.
+ */
+typedef struct _Trace {
+  FILE *file;
+  trace_format_t format;
+  char *buffer;
+  size_t length;
+  /* Rank of the VMs in the trace (stored as rank+1, as NULL means not found) */
+  xbt_dict_t VM_ids;
+} Trace;
+
+static Trace *trace = NULL;
+
+static const char *event_names[] = {"task_start", "task_end", "vm_start", "vm_terminate", "period"};
+
+static void trace_flush(){
+  if (trace->length && fwrite(trace->buffer, 1, trace->length, trace->file) != trace->length)
+    xbt_die("Cannot write the trace");
+  trace->length = 0;
+}
+
+static int trace_get_id(xbt_dict_t ids, const char *name){
+  return (int) (intptr_t) xbt_dict_get_or_null(ids, name) - 1;
+}
+
+static void trace_write(trace_event_t event, double time, sg_host_t host, SD_task_t task, double utilization,
+                        double consumed_budget){
+  trace_record_t record;
+
+  if (trace->length + 512 > TRACE_BUFFER_SIZE)
+    trace_flush();
+
+  if (trace->format == TRACE_BINARY){
+    record.time = time;
+    record.utilization = utilization;
+    record.consumed_budget = consumed_budget;
+    record.event = event;
+    record.vm = host ? trace_get_id(trace->VM_ids, sg_host_get_name(host)) : -1;
+    record.dax = task ? SD_task_get_dax_id(task) : -1;
+    record.task = task ? ((TaskAttribute) SD_task_get_data(task))->dax_index : -1;
+    memcpy(trace->buffer + trace->length, &record, sizeof(trace_record_t));
+    trace->length += sizeof(trace_record_t);
+    return;
+  }
+
+  trace->length += sprintf(trace->buffer + trace->length, "%.6f,%s,", time, event_names[event]);
+  if (host)
+    trace->length += sprintf(trace->buffer + trace->length, "%.200s", sg_host_get_name(host));
+  if (task)
+    trace->length += sprintf(trace->buffer + trace->length, ",%.150s,%.150s,", SD_task_get_dax_name(task),
+                             SD_task_get_name(task));
+  else
+    trace->length += sprintf(trace->buffer + trace->length, ",,,");
+  if (event == TRACE_PERIOD)
+    trace->length += sprintf(trace->buffer + trace->length, "%.2f,%.2f\n", utilization, consumed_budget);
+  else
+    trace->length += sprintf(trace->buffer + trace->length, ",\n");
+}
+
+/* Open a trace for the simulation of the loaded DAXes. In binary mode, the names of the VMs and of the DAXes are
+ * written first.
+ */
+void trace_open(const char *filename, trace_format_t format){
+  unsigned int i;
+  uint32_t header[3];
+  const sg_host_t *hosts = sg_host_list();
+  const char *name;
+
+  trace = (Trace *) calloc (1, sizeof(Trace));
+  trace->file = fopen(filename, format == TRACE_BINARY ? "wb" : "w");
+  if (!trace->file)
+    xbt_die("Cannot open %s to dump the schedule", filename);
+  trace->format = format;
+  trace->buffer = (char *) malloc (TRACE_BUFFER_SIZE);
+  trace->VM_ids = xbt_dict_new_homogeneous(NULL);
+
+  for (i = 0; i < sg_host_count(); i++)
+    xbt_dict_set(trace->VM_ids, sg_host_get_name(hosts[i]), (void *) (intptr_t) (i + 1), NULL);
+
+  if (format == TRACE_CSV){
+    fprintf(trace->file, "time,event,vm,dax,task,utilization,consumed_budget\n");
+    return;
+  }
+
+  header[0] = TRACE_VERSION;
+  header[1] = sg_host_count();
+  header[2] = get_number_of_daxes();
+  fwrite(TRACE_MAGIC, 1, 8, trace->file);
+  fwrite(header, sizeof(uint32_t), 3, trace->file);
+  for (i = 0; i < sg_host_count(); i++){
+    name = sg_host_get_name(hosts[i]);
+    fwrite(name, 1, strlen(name) + 1, trace->file);
+  }
+  for (i = 0; i < get_number_of_daxes(); i++){
+    name = get_dax_descriptor(i)->name;
+    fwrite(name, 1, strlen(name) + 1, trace->file);
+  }
+}
+
+void trace_close(){
+  if (!trace)
+    return;
+  trace_flush();
+  if (fclose(trace->file))
+    xbt_die("Cannot write the trace");
+  xbt_dict_free(&(trace->VM_ids));
+  free(trace->buffer);
+  free(trace);
+  trace = NULL;
+}
+
+/* Record the execution of a compute task, once it is done. Its start and end are both written at this point, hence
+ * the trace is not sorted by time.
+ */
+void trace_task(SD_task_t task){
+  sg_host_t host;
+
+  if (!trace)
+    return;
+  host = engine_task_get_host(task);
+  trace_write(TRACE_TASK_START, engine_task_get_start_time(task), host, task, 0., 0.);
+  trace_write(TRACE_TASK_END, engine_task_get_finish_time(task), host, task, 0., 0.);
+}
+
+void trace_VM_start(sg_host_t host){
+  if (trace)
+    trace_write(TRACE_VM_START, engine_get_clock(), host, NULL, 0., 0.);
+}
+
+void trace_VM_terminate(sg_host_t host){
+  if (trace)
+    trace_write(TRACE_VM_TERMINATE, engine_get_clock(), host, NULL, 0., 0.);
+}
+
+/* Record the VM utilization and the consumed budget at the end of a provisioning period */
+void trace_period(double utilization, double consumed_budget){
+  if (trace)
+    trace_write(TRACE_PERIOD, engine_get_clock(), NULL, NULL, utilization, consumed_budget);
+}
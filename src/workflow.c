@@ -0,0 +1,452 @@
+/*
+ * Copyright (c) Centre de Calcul de l'IN2P3 du CNRS
+ * Contributor(s) : Frédéric SUTER (2012-2016)
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the license (GNU LGPL) which comes with this package.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "xbt.h"
+#include "simgrid/simdag.h"
+#include "dax.h"
+#include "task.h"
+#include "workflow.h"
+
+XBT_LOG_NEW_DEFAULT_SUBCATEGORY(workflow, EnsembleSched, "Logging specific to workflow loading");
+
+/*****************************************************************************/
+/*****************************************************************************/
+/**************            Binary image of a parsed DAX         **************/
+/*****************************************************************************/
+/*****************************************************************************/
+
+/* Parsing the XML description of a DAX is by far the most expensive part of its loading. A parsed DAX can thus be
+ * saved as a binary image that is directly mapped in memory and from which SimDAG tasks are built. This image is made
+ * of (all integers being indexes in arrays of the image):
+ * - a header;
+ * - one record per task, in the order of the DAX, plus a sentinel record to delimit the ranges of the last task;
+ * - the sizes of the data sent through the edges of the compute-only dependency graph, in the order of the children;
+ * - the targets of the dependencies of all the tasks (transfers included), as built by SD_daxload;
+ * - the children of all the tasks in the compute-only dependency graph (see build_compute_graph);
+ * - a table of strings, i.e., the names of the tasks.
+ * Images are stored in a cache directory and named after a hash of the content of the XML file. A modified DAX thus
+ * never matches an outdated image.
+ */
+#define WORKFLOW_IMAGE_MAGIC "ESDAX"
+
+typedef struct {
+  char magic[8];
+  uint32_t version;
+  uint32_t ntasks;
+  uint32_t ndependencies;
+  uint32_t ncompute_edges;
+  uint64_t content_hash;
+  uint64_t size;                 /* size of the whole image in bytes */
+} image_header_t;
+
+typedef struct {
+  double amount;
+  uint32_t kind;
+  uint32_t name;                 /* offset of the name in the table of strings */
+  uint32_t first_dependency;
+  uint32_t first_compute_child;
+} image_task_t;
+
+typedef struct {
+  image_header_t *header;
+  image_task_t *tasks;
+  double *compute_sizes;
+  uint32_t *dependencies;
+  uint32_t *compute_children;
+  char *strings;
+} image_t;
+
+/* Hash the content of a file with the 64 bits version of FNV-1a. Return 0 if the file cannot be read. */
+static uint64_t hash_file(const char *filename){
+  uint64_t hash = 14695981039346656037ULL;
+  unsigned char buffer[65536];
+  size_t n, i;
+  FILE *f = fopen(filename, "rb");
+
+  if (!f)
+    return 0;
+  while ((n = fread(buffer, 1, sizeof(buffer), f)) > 0)
+    for (i = 0; i < n; i++)
+      hash = (hash ^ buffer[i]) * 1099511628211ULL;
+  fclose(f);
+
+  return hash;
+}
+
+/* Locate the different parts of an image that starts at the given address */
+static image_t image_parts(void *address){
+  image_t image;
+
+  image.header = (image_header_t *) address;
+  image.tasks = (image_task_t *) (image.header + 1);
+  image.compute_sizes = (double *) (image.tasks + image.header->ntasks + 1);
+  image.dependencies = (uint32_t *) (image.compute_sizes + image.header->ncompute_edges);
+  image.compute_children = image.dependencies + image.header->ndependencies;
+  image.strings = (char *) (image.compute_children + image.header->ncompute_edges);
+
+  return image;
+}
+
+/* Build the binary image of a loaded DAX. The attributes of the tasks and the compute-only dependency graph have to
+ * be set. Return a buffer to be freed by the caller.
+ */
+static void *image_build(xbt_dynar_t dax, uint64_t content_hash){
+  unsigned int i, j;
+  uint32_t ntasks = xbt_dynar_length(dax), ndependencies = 0, ncompute_edges = 0;
+  uint64_t strings_size = 0, size;
+  xbt_dynar_t children;
+  SD_task_t task, child;
+  image_t image;
+  char *buffer;
+
+  xbt_dynar_foreach(dax, i, task){
+    children = SD_task_get_children(task);
+    ndependencies += xbt_dynar_length(children);
+    xbt_dynar_free_container(&children); /* avoid memory leaks */
+    ncompute_edges += SD_task_get_compute_children_count(task);
+    strings_size += strlen(SD_task_get_name(task)) + 1;
+  }
+
+  size = sizeof(image_header_t) + (ntasks + 1) * sizeof(image_task_t) + ncompute_edges * sizeof(double) +
+      (ndependencies + ncompute_edges) * sizeof(uint32_t) + strings_size;
+  buffer = (char *) calloc (1, size);
+
+  image.header = (image_header_t *) buffer;
+  strcpy(image.header->magic, WORKFLOW_IMAGE_MAGIC);
+  image.header->version = WORKFLOW_IMAGE_VERSION;
+  image.header->ntasks = ntasks;
+  image.header->ndependencies = ndependencies;
+  image.header->ncompute_edges = ncompute_edges;
+  image.header->content_hash = content_hash;
+  image.header->size = size;
+  image = image_parts(buffer);
+
+  ndependencies = ncompute_edges = strings_size = 0;
+  xbt_dynar_foreach(dax, i, task){
+    image.tasks[i].amount = SD_task_get_amount(task);
+    image.tasks[i].kind = SD_task_get_kind(task);
+    image.tasks[i].name = strings_size;
+    image.tasks[i].first_dependency = ndependencies;
+    image.tasks[i].first_compute_child = ncompute_edges;
+
+    strcpy(image.strings + strings_size, SD_task_get_name(task));
+    strings_size += strlen(SD_task_get_name(task)) + 1;
+
+    children = SD_task_get_children(task);
+    xbt_dynar_foreach(children, j, child)
+      image.dependencies[ndependencies++] = ((TaskAttribute) SD_task_get_data(child))->dax_index;
+    xbt_dynar_free_container(&children); /* avoid memory leaks */
+
+    for (j = 0; j < SD_task_get_compute_children_count(task); j++){
+      image.compute_sizes[ncompute_edges] = ((TaskAttribute) SD_task_get_data(task))->output_sizes[j];
+      image.compute_children[ncompute_edges++] =
+          ((TaskAttribute) SD_task_get_data(SD_task_get_compute_children(task)[j]))->dax_index;
+    }
+  }
+  image.tasks[ntasks].first_dependency = ndependencies;
+  image.tasks[ntasks].first_compute_child = ncompute_edges;
+
+  return buffer;
+}
+
+/* Write an image in the cache. The image is first written in a temporary file which is then renamed, so that
+ * concurrent runs never read a partially written image.
+ */
+static void image_save(const char *path, void *image){
+  char tmp_path[4096];
+  FILE *f;
+
+  snprintf(tmp_path, sizeof(tmp_path), "%s.%d.tmp", path, (int) getpid());
+  f = fopen(tmp_path, "wb");
+  if (!f){
+    XBT_WARN("Cannot write %s. The parsed DAX is not cached", tmp_path);
+    return;
+  }
+  if (fwrite(image, ((image_header_t *) image)->size, 1, f) != 1 || fclose(f) || rename(tmp_path, path)){
+    XBT_WARN("Failed to write %s. The parsed DAX is not cached", path);
+    unlink(tmp_path);
+  }
+}
+
+/* Map an image from the cache in memory. Return NULL if the image does not exist or is invalid (e.g., it was written
+ * by another version of the program).
+ */
+static void *image_map(const char *path, uint64_t content_hash, size_t *size){
+  struct stat st;
+  void *address;
+  image_header_t *header;
+  int fd = open(path, O_RDONLY);
+
+  if (fd < 0)
+    return NULL;
+  if (fstat(fd, &st) || st.st_size < sizeof(image_header_t)){
+    close(fd);
+    return NULL;
+  }
+  address = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (address == MAP_FAILED)
+    return NULL;
+
+  header = (image_header_t *) address;
+  if (strcmp(header->magic, WORKFLOW_IMAGE_MAGIC) || header->version != WORKFLOW_IMAGE_VERSION ||
+      header->content_hash != content_hash || header->size != st.st_size){
+    XBT_VERB("%s is stale, ignore it", path);
+    munmap(address, st.st_size);
+    return NULL;
+  }
+  *size = st.st_size;
+  return address;
+}
+
+/* Build the SimDAG tasks of a DAX from its image. Tasks are created in the same order as in the DAX, and so are the
+ * dependencies of each task, which gives the same children lists as SD_daxload. If transfers are folded, only the
+ * compute tasks are created, and the edges of the compute-only graph become control dependencies. The position in the
+ * built DAX of each task of the image (-1 for a transfer that is not built) is stored in index.
+ */
+static xbt_dynar_t image_instantiate(void *address, int fold_transfers, int *index){
+  uint32_t i, j;
+  image_t image = image_parts(address);
+  xbt_dynar_t dax = xbt_dynar_new(sizeof(SD_task_t), NULL);
+  SD_task_t task, *tasks;
+
+  for (i = 0; i < image.header->ntasks; i++){
+    switch (image.tasks[i].kind){
+    case SD_TASK_COMP_SEQ:
+      task = SD_task_create_comp_seq(image.strings + image.tasks[i].name, NULL, image.tasks[i].amount);
+      break;
+    case SD_TASK_COMM_E2E:
+      if (fold_transfers){
+        index[i] = -1;
+        continue;
+      }
+      task = SD_task_create_comm_e2e(image.strings + image.tasks[i].name, NULL, image.tasks[i].amount);
+      break;
+    default:
+      xbt_die("Unsupported kind of task in a parsed DAX: %u", image.tasks[i].kind);
+    }
+    index[i] = xbt_dynar_length(dax);
+    xbt_dynar_push(dax, &task);
+  }
+
+  tasks = (SD_task_t *) xbt_dynar_get_ptr(dax, 0);
+  for (i = 0; i < image.header->ntasks; i++){
+    if (fold_transfers){
+      for (j = image.tasks[i].first_compute_child; j < image.tasks[i+1].first_compute_child; j++)
+        SD_task_dependency_add(NULL, NULL, tasks[index[i]], tasks[index[image.compute_children[j]]]);
+    } else {
+      for (j = image.tasks[i].first_dependency; j < image.tasks[i+1].first_dependency; j++)
+        SD_task_dependency_add(NULL, NULL, tasks[i], tasks[image.dependencies[j]]);
+    }
+  }
+
+  return dax;
+}
+
+/*****************************************************************************/
+/*****************************************************************************/
+/**************                  DAX loading                    **************/
+/*****************************************************************************/
+/*****************************************************************************/
+
+/* A workflow template is the image of a parsed DAX, either mapped from the cache or built in memory. A DAX file is
+ * parsed (or mapped) only once, however many times it appears in the ensemble. Each occurrence is then an independent
+ * instance built from the template.
+ */
+typedef struct _WorkflowTemplate *workflow_template_t;
+struct _WorkflowTemplate {
+  void *image;
+  size_t size;
+  int mapped;      /* 1 if the image is mapped from the cache, 0 if it was allocated */
+};
+
+/* Templates indexed by file name */
+static xbt_dict_t templates = NULL;
+
+static network_model_t network_model = NETWORK_FULL;
+
+void set_network_model(network_model_t model){
+  network_model = model;
+}
+
+network_model_t getNetworkModelByName(const char *name){
+  if (!strcmp(name, "full"))
+    return NETWORK_FULL;
+  else if (!strcmp(name, "latency"))
+    return NETWORK_LATENCY;
+  else if (!strcmp(name, "none"))
+    return NETWORK_NONE;
+  else
+    xbt_die("Unknown network model: %s", name);
+}
+
+static void free_template(void *data){
+  workflow_template_t template = (workflow_template_t) data;
+
+  if (template->mapped)
+    munmap(template->image, template->size);
+  else
+    free(template->image);
+  free(template);
+}
+
+/* Allocate the attributes of the tasks of a freshly built DAX, register the completion of compute tasks as watch
+ * points, and create the descriptor of the DAX
+ */
+static void init_tasks(xbt_dynar_t dax, const char *daxname){
+  unsigned int i;
+  SD_task_t task;
+
+  xbt_dynar_foreach(dax, i, task){
+    if (SD_task_get_kind(task) == SD_TASK_COMP_SEQ){
+      SD_task_watch(task, SD_DONE);
+    }
+  }
+  SD_task_allocate_attributes(dax);
+  register_dax(dax, daxname);
+}
+
+/* Build a new instance of a workflow from its template. The compute-only dependency graph is also read from the
+ * image, and its edges lose their sizes if the network is not modeled. As transfers have no compute children, the
+ * ranges of children of the compute tasks stay the same when transfers are folded.
+ */
+static xbt_dynar_t instantiate_template(workflow_template_t template, const char *daxname){
+  uint32_t i, n = 0;
+  int *offsets, *children, *index;
+  image_t parts = image_parts(template->image);
+  xbt_dynar_t dax;
+
+  index = (int *) calloc (parts.header->ntasks, sizeof(int));
+  dax = image_instantiate(template->image, network_model != NETWORK_FULL, index);
+  init_tasks(dax, daxname);
+
+  offsets = (int *) calloc (xbt_dynar_length(dax) + 1, sizeof(int));
+  for (i = 0; i < parts.header->ntasks; i++)
+    if (index[i] >= 0)
+      offsets[n++] = parts.tasks[i].first_compute_child;
+  offsets[n] = parts.tasks[parts.header->ntasks].first_compute_child;
+  children = (int *) calloc (parts.header->ncompute_edges + 1, sizeof(int));
+  for (i = 0; i < parts.header->ncompute_edges; i++)
+    children[i] = index[parts.compute_children[i]];
+  set_compute_graph(dax, offsets, children, (network_model == NETWORK_NONE) ? NULL : parts.compute_sizes);
+  free(children);
+  free(offsets);
+  free(index);
+
+  return dax;
+}
+
+/* Turn a DAX built by the parser, whose compute-only dependency graph is set, into the same DAX as instantiate_template
+ * builds when transfers are folded: transfers are destroyed, the dependencies between compute tasks are replaced by
+ * the edges of the compute-only graph, in the same order, and the attributes are moved to a slab of compute tasks only.
+ */
+static void fold_transfers(xbt_dynar_t dax){
+  unsigned int i, n = 0;
+  int k, nedges = 0;
+  SD_task_t task, *tasks = (SD_task_t *) xbt_dynar_get_ptr(dax, 0);
+  TaskAttribute attr, slab, old_slab = (TaskAttribute) SD_task_get_data(get_root(dax));
+  DaxDescriptor descriptor = get_dax_descriptor(SD_task_get_dax_id(get_root(dax)));
+
+  slab = (TaskAttribute) calloc (descriptor->ncompute_tasks, sizeof(struct _TaskAttribute));
+  for (i = 0; i < xbt_dynar_length(dax); i++){
+    if (SD_task_get_kind(tasks[i]) != SD_TASK_COMP_SEQ){
+      SD_task_destroy(tasks[i]);
+      continue;
+    }
+    slab[n] = *((TaskAttribute) SD_task_get_data(tasks[i]));
+    slab[n].dax_index = n;
+    SD_task_set_data(tasks[i], &(slab[n]));
+    tasks[n++] = tasks[i];
+  }
+  while (xbt_dynar_length(dax) > n)
+    xbt_dynar_pop(dax, &task);
+  free(old_slab);
+
+  for (i = 0; i < n; i++){
+    attr = (TaskAttribute) SD_task_get_data(tasks[i]);
+    nedges += attr->nchildren;
+    for (k = 0; k < attr->nchildren; k++){
+      if (SD_task_dependency_exists(tasks[i], attr->children[k]))
+        SD_task_dependency_remove(tasks[i], attr->children[k]);
+      SD_task_dependency_add(NULL, NULL, tasks[i], attr->children[k]);
+    }
+  }
+  /* Without network, edges are only control dependencies */
+  if (network_model == NETWORK_NONE)
+    for (k = 0; k < 2*nedges; k++)
+      descriptor->edge_sizes[k] = -1.;
+  descriptor->ntasks = n;
+}
+
+/* Load an instance of a DAX, named daxname. The first time a file is loaded, a template is created:
+ *  - if a cache directory is given, the content of the file is hashed to find the corresponding image in the cache.
+ *  - otherwise, or if there is no such image, the XML file is parsed and its image is built (and added to the cache).
+ *    The tasks created by the parser are then directly used as the first instance, once their transfers are folded
+ *    if the network is not fully modeled.
+ * All the other instances of the same file are built from the template.
+ */
+xbt_dynar_t load_dax(const char *filename, const char *cache_dir, const char *daxname){
+  char path[4096];
+  uint64_t content_hash = 0;
+  xbt_dynar_t dax;
+  workflow_template_t template;
+
+  if (!templates)
+    templates = xbt_dict_new_homogeneous(free_template);
+
+  template = (workflow_template_t) xbt_dict_get_or_null(templates, filename);
+  if (template){
+    XBT_DEBUG("Instantiate %s from the template of %s", daxname, filename);
+    return instantiate_template(template, daxname);
+  }
+
+  template = (workflow_template_t) calloc (1, sizeof(struct _WorkflowTemplate));
+  if (cache_dir){
+    content_hash = hash_file(filename);
+    if (!content_hash)
+      xbt_die("Cannot read %s", filename);
+    snprintf(path, sizeof(path), "%s/%016llx.sdax", cache_dir, (unsigned long long) content_hash);
+
+    template->image = image_map(path, content_hash, &(template->size));
+    if (template->image){
+      XBT_DEBUG("Load %s from %s", filename, path);
+      template->mapped = 1;
+      xbt_dict_set(templates, filename, template, NULL);
+      return instantiate_template(template, daxname);
+    }
+    XBT_DEBUG("No valid image of %s in %s. Parse it", filename, cache_dir);
+  }
+
+  dax = SD_daxload(filename);
+  init_tasks(dax, daxname);
+  build_compute_graph(dax);
+
+  template->image = image_build(dax, content_hash);
+  template->size = ((image_header_t *) template->image)->size;
+  template->mapped = 0;
+  if (cache_dir)
+    image_save(path, template->image);
+  xbt_dict_set(templates, filename, template, NULL);
+
+  if (network_model != NETWORK_FULL)
+    fold_transfers(dax);
+
+  return dax;
+}
+
+/* Release all the templates once all the instances have been built */
+void free_dax_templates(){
+  if (templates)
+    xbt_dict_free(&templates);
+}